@@ -0,0 +1,56 @@
+#include "allocationcounter.h"
+
+#include <cstddef>
+
+#if defined(COUNT_ALLOCATIONS) && defined(__GLIBC__)
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+}
+
+// initial-exec TLS; reading it never allocates, so it is safe in malloc
+static thread_local uint64_t threadAllocations = 0;
+
+extern "C" void *malloc(size_t size)
+{
+    threadAllocations++;
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+    threadAllocations++;
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+    threadAllocations++;
+    return __libc_realloc(ptr, size);
+}
+
+bool AllocationCounter::enabled()
+{
+    return true;
+}
+
+uint64_t AllocationCounter::count()
+{
+    return threadAllocations;
+}
+
+#else
+
+bool AllocationCounter::enabled()
+{
+    return false;
+}
+
+uint64_t AllocationCounter::count()
+{
+    return 0;
+}
+
+#endif
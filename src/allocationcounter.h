@@ -0,0 +1,24 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <cstdint>
+
+/**
+  * AllocationCounter
+  * Heap allocations made by the calling thread, counted by wrapping
+  * malloc when built with CONFIG += count_allocations (glibc only).
+  * Qt containers allocate through malloc, so QByteArray and QString
+  * buffers are counted along with operator new
+  */
+class AllocationCounter
+{
+public:
+
+    static bool enabled();
+
+    // allocations so far on this thread; 0 when not enabled
+    static uint64_t count();
+
+};
+
+#endif // ALLOCATIONCOUNTER_H
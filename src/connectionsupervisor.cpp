@@ -0,0 +1,141 @@
+#include "connectionsupervisor.h"
+
+#include <QDebug>
+#include <QStringList>
+
+ConnectionSupervisor::ConnectionSupervisor(QString name,
+                                           std::function<void()> attempt,
+                                           QObject *parent) :
+    QObject(parent),
+    random(std::random_device()())
+{
+    _name = name;
+    this->attempt = attempt;
+
+    retryTimer = new QTimer(this);
+    retryTimer->setSingleShot(true);
+    connect(retryTimer, &QTimer::timeout,
+            this, &ConnectionSupervisor::attemptNow);
+
+    attemptTimer = new QTimer(this);
+    attemptTimer->setSingleShot(true);
+    connect(attemptTimer, &QTimer::timeout,
+            this, &ConnectionSupervisor::attemptTimedOut);
+}
+
+void ConnectionSupervisor::setAttemptTimeout(std::function<void()> abort, int msecs)
+{
+    this->abort = abort;
+    attemptTimer->setInterval(msecs);
+}
+
+void ConnectionSupervisor::start()
+{
+    if (state != Stopped) return;
+    failures = 0;
+    downTime.start();
+    attemptNow();
+}
+
+void ConnectionSupervisor::stop()
+{
+    retryTimer->stop();
+    attemptTimer->stop();
+    state = Stopped;
+}
+
+void ConnectionSupervisor::attemptNow()
+{
+    state = Connecting;
+    _stats.attempts++;
+    if (abort) attemptTimer->start();
+    attempt();
+}
+
+// The attempt is counted as failed first, so the link down its abort
+// reports is ignored and the backoff carries on from here
+void ConnectionSupervisor::attemptTimedOut()
+{
+    if (state != Connecting) return;
+
+    _stats.timeouts++;
+    qDebug() << qPrintable(QString("%1 connect attempt timed out after %2 ms")
+        .arg(_name).arg(attemptTimer->interval()));
+    linkDown();
+    abort();
+}
+
+void ConnectionSupervisor::linkUp()
+{
+    retryTimer->stop();
+    attemptTimer->stop();
+
+    if (wasUp && state != Up) {
+        int64_t down = downTime.elapsed();
+        _stats.reconnects++;
+        _stats.lastReconnectMsecs = down;
+        if (down > _stats.maxReconnectMsecs) _stats.maxReconnectMsecs = down;
+
+        int bucket = 0;
+        while (bucket < histogramBuckets - 1 && down >= histogramBoundsMsecs[bucket])
+            bucket++;
+        _stats.reconnectHistogram[bucket]++;
+
+        qDebug() << qPrintable(QString("%1 reconnected after %2 ms, %3 attempts")
+            .arg(_name).arg(down).arg(failures + 1));
+        emit reconnected(down);
+    }
+
+    state = Up;
+    wasUp = true;
+    failures = 0;
+}
+
+/**
+  * linkDown()
+  * Called for a dropped link and for a failed attempt alike; while a
+  * retry is already scheduled further reports are ignored
+  */
+void ConnectionSupervisor::linkDown()
+{
+    if (state == Stopped || state == Waiting) return;
+    attemptTimer->stop();
+
+    if (state == Up) {
+        downTime.start();
+        failures = 0;
+        qDebug() << qPrintable(QString("%1 down; reconnecting").arg(_name));
+    } else {
+        failures++;
+    }
+
+    state = Waiting;
+    retryTimer->start(nextDelay());
+}
+
+// 0 for the first retry, then initialDelayMsecs doubling to
+// maxDelayMsecs, each picked between half and all of that
+int ConnectionSupervisor::nextDelay()
+{
+    if (failures == 0) return 0;
+
+    int64_t delay = initialDelayMsecs;
+    for (int i = 1; i < failures && delay < maxDelayMsecs; i++) delay *= 2;
+    if (delay > maxDelayMsecs) delay = maxDelayMsecs;
+
+    std::uniform_int_distribution<int> jitter(static_cast<int>(delay / 2),
+                                              static_cast<int>(delay));
+    return jitter(random);
+}
+
+QString ConnectionSupervisor::histogramString() const
+{
+    QStringList buckets;
+    for (int i = 0; i < histogramBuckets; i++) {
+        QString label = (i < histogramBuckets - 1)
+                ? QString("<%1s").arg(histogramBoundsMsecs[i] / 1000)
+                : QString(">=%1s").arg(histogramBoundsMsecs[i - 1] / 1000);
+        buckets << QString("%1:%2").arg(label).arg(_stats.reconnectHistogram[i]);
+    }
+    return buckets.join(" ");
+}
@@ -0,0 +1,99 @@
+#ifndef CONNECTIONSUPERVISOR_H
+#define CONNECTIONSUPERVISOR_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include <functional>
+#include <random>
+
+/**
+  * ConnectionSupervisor
+  * Keeps one link up: the first retry after a drop is immediate, then
+  * the delay doubles from initialDelayMsecs up to maxDelayMsecs, each
+  * spread by jitter so reconnects from many clients do not line up.
+  * The owner reports linkUp() and linkDown(); the supervisor calls
+  * the attempt function, and the abort function if an attempt is
+  * still unanswered after the attempt timeout
+  */
+class ConnectionSupervisor : public QObject
+{
+    Q_OBJECT
+public:
+
+    static const int initialDelayMsecs = 1000;
+    static const int maxDelayMsecs = 60000;
+
+    // well inside the OS connect timeout, which runs to minutes
+    static const int defaultAttemptTimeoutMsecs = 10000;
+
+    // time to reconnect buckets, upper bounds; the last bucket is open
+    static const int histogramBuckets = 8;
+    static constexpr int histogramBoundsMsecs[histogramBuckets - 1] = {
+        1000, 2000, 5000, 10000, 30000, 60000, 300000
+    };
+
+    struct Stats {
+        uint64_t attempts = 0;
+        uint64_t timeouts = 0;      // attempts aborted unanswered
+        uint64_t reconnects = 0;
+        int64_t lastReconnectMsecs = 0;
+        int64_t maxReconnectMsecs = 0;
+        uint64_t reconnectHistogram[histogramBuckets] = {};
+    };
+
+    ConnectionSupervisor(QString name, std::function<void()> attempt,
+                         QObject *parent = nullptr);
+
+    // begin connecting and keep the link up
+    void start();
+
+    // give up the link; any pending attempt is cancelled
+    void stop();
+
+    // abort must drop the connection in progress; linkDown() reports
+    // made from it are ignored. No timeout without an abort function
+    void setAttemptTimeout(std::function<void()> abort,
+                           int msecs = defaultAttemptTimeoutMsecs);
+
+    void linkUp();
+    void linkDown();
+
+    bool isUp() const { return state == Up; }
+    const Stats &stats() const { return _stats; }
+    QString name() const { return _name; }
+
+    // eg. "<1s:3 <2s:1 ... >=300s:0"
+    QString histogramString() const;
+
+signals:
+
+    void reconnected(int64_t downMsecs);
+
+private:
+
+    enum State { Stopped, Connecting, Up, Waiting };
+
+    void attemptNow();
+    void attemptTimedOut();
+    int nextDelay();
+
+    QString _name;
+    std::function<void()> attempt;
+    std::function<void()> abort;
+    State state = Stopped;
+    int failures = 0;
+
+    QTimer *retryTimer;
+    QTimer *attemptTimer;
+    QElapsedTimer downTime; // since the link was last lost
+    bool wasUp = false;
+
+    std::mt19937 random;
+
+    Stats _stats;
+
+};
+
+#endif // CONNECTIONSUPERVISOR_H
@@ -10,30 +10,24 @@
 
 namespace it100 {
 
-IT100::IT100(InterfaceType interfaceType, bool debugMode)
+IT100::IT100(bool debugMode)
 {
-    // reserved for serial port
-    Q_UNUSED(interfaceType)
-
     _debugMode = debugMode;
     
     // we have not yet begun communicating
-    _connectionIntent = false;
-    _connectionAttempts = 0;
     communicationsGood = false;
-    waitingForResponse = false;
     _waitingForStatusUpdate = false;
 
-    // Create TCP Socket
     _connected = false;
-    socket = new QTcpSocket();
-    connect(socket, &QTcpSocket::readyRead,
-        this, &IT100::processTcpSocketReadyRead);
-    connect(socket, &QTcpSocket::stateChanged,
-            this, &IT100::processTcpSocketStateChange);
 
-    // Module Reconnect Timer
-    moduleReconnectTimer = new QTimer();
+    // Module Reconnect Supervisor
+    // never give up!
+    linkSupervisor = new ConnectionSupervisor("it100", [this]() {
+        if (_debugMode) qDebug() << qPrintable(
+            QString("connecting to it100 %1").arg(transport->name()));
+        transport->open();
+    }, this);
+    linkSupervisor->setAttemptTimeout([this]() { transport->close(); });
 
     // Panel Clock Discipline Timer
     // Keep DSC alarm panel in sync with system time
@@ -53,6 +47,37 @@ IT100::IT100(InterfaceType interfaceType, bool debugMode)
     connect(pollTimer, &QTimer::timeout,
         this, &IT100::onPollTimerTimeout);
 
+    // Command Acknowledgement Deadline Timer
+    // Armed for the oldest command awaiting acknowledgement
+    linkClock.start();
+    commandDeadlineTimer = new QTimer(this);
+    commandDeadlineTimer->setSingleShot(true);
+    connect(commandDeadlineTimer, &QTimer::timeout,
+        this, &IT100::onCommandDeadlineTimerTimeout);
+
+    // Transmit Pacing Timer
+    // Resumes writePacket() once the line has room
+    pacer.setBurstBytes(It100Message::maxPacketLength);
+    pacer.resetUtilization(linkClock.elapsed());
+    transmitPacingTimer = new QTimer(this);
+    transmitPacingTimer->setSingleShot(true);
+    connect(transmitPacingTimer, &QTimer::timeout,
+        this, &IT100::writePacket);
+
+    // Virtual Keypad Sequence Timer
+    keySequenceTimer = new QTimer(this);
+    keySequenceTimer->setSingleShot(true);
+    connect(keySequenceTimer, &QTimer::timeout,
+        this, &IT100::onKeySequenceTimerTimeout);
+
+    // Status Snapshot Timer
+    // Gives up on a response whose end marker never comes
+    snapshotTimeoutTimer = new QTimer(this);
+    snapshotTimeoutTimer->setSingleShot(true);
+    snapshotTimeoutTimer->setInterval(statusSnapshotTimeoutSecs * 1000);
+    connect(snapshotTimeoutTimer, &QTimer::timeout,
+        this, &IT100::onSnapshotTimeoutTimerTimeout);
+
 }
 
 bool IT100::setUserCode(uint32_t code)
@@ -78,57 +103,70 @@ bool IT100::setProgrammerCode(uint32_t code)
 }
 
 /**
-  * onDataAvailable()
+  * processReadyRead()
+  * Read straight into the line framer and process each complete line
   */
-void IT100::processTcpSocketReadyRead()
-{
-    int64_t numBytesAvail = socket->bytesAvailable();
-    if (!numBytesAvail) return;
- 
-    QByteArray receivedBytes;
-    receivedBytes.resize(static_cast<int>(numBytesAvail));
-    socket->read(receivedBytes.data(),receivedBytes.size());
-
-    // Tokenize for newlines
-    receivedData += QString::fromUtf8(receivedBytes.data(),
-                                      receivedBytes.size());
-    if(receivedData.contains('\n'))
-    {
-        QStringList lineList=receivedData.split(QRegExp("\r\n|\n"));
-        //If line ends with \n lineList will contain a trailing empty string
-        //otherwise it will contain part of a line without the terminating \n
-        //In both cases lineList.at(lineList.size()-1) should not be sent
-        //with emit.
-        int numLines=lineList.size()-1;
-        receivedData=lineList.at(lineList.size()-1);
-        for(int i=0;i<numLines;i++)
-        {
-            emit lineReceived(lineList.at(i));
-            processReceivedLine(lineList.at(i).toUtf8());
+void IT100::processReadyRead()
+{
+    int lines = 0;
+    bool notifyLines = isSignalConnected(QMetaMethod::fromSignal(&IT100::lineReceived));
+
+    forever {
+        int64_t numBytesRead = transport->read(framer.writePointer(),
+                                               framer.writeAvailable());
+        if (numBytesRead <= 0) break;
+        framer.commit(static_cast<int>(numBytesRead));
+
+        LineView line;
+        while (framer.nextLine(line)) {
+            lines++;
+            if (notifyLines)
+                emit lineReceived(QString::fromLatin1(line.data, line.size));
+            processReceivedLine(line);
         }
     }
 
+    framer.endRead(lines);
 }
 
 /**
-  * open(portName)
+  * setTransport(transport)
+  * Link to the module; IT100 takes ownership. Replaces (and
+  * deletes) any previous transport
   */
-void IT100::open(QHostAddress remoteAddr, uint16_t port)
+void IT100::setTransport(Transport *transport)
 {
-    remoteHostAddress = remoteAddr;
-    remoteHostPort = port;
-
-    // maintain connection after disconnect
-    _connectionAttempts++;
-    _connectionIntent = true;
+    if (this->transport) {
+        this->transport->disconnect(this);
+        this->transport->close();
+        this->transport->deleteLater();
+    }
 
-    socket->connectToHost(remoteAddr,port);
+    this->transport = transport;
+    transport->setParent(this);
+    connect(transport, &Transport::readyRead,
+        this, &IT100::processReadyRead);
+    connect(transport, &Transport::connected,
+        this, &IT100::processLinkUp);
+    connect(transport, &Transport::disconnected,
+        this, &IT100::processLinkDown);
 }
 
+/**
+  * open()
+  * Bring up the transport and keep it up; a TCP link reports in
+  * later, a tty straight away
+  */
 void IT100::open()
 {
-    if (remoteHostAddress.isNull() || remoteHostPort == 0) return;
-    open(remoteHostAddress,remoteHostPort);
+    if (!transport) return;
+    linkSupervisor->start();
+}
+
+// Where the IT-100 is reached, for log messages
+QString IT100::linkName()
+{
+    return transport ? transport->name() : QString("(no transport)");
 }
 
 void IT100::processTcpSocketConnected()
@@ -142,369 +180,344 @@ void IT100::processTcpSocketConnected()
     // onTimeDisciplineTimerTimeout();
 
     // Request System Status
-    // Prepare for the flood
-    _waitingForStatusUpdate = true;
-    sendCommand(CMD_STATUS_REQUEST);
+    requestStatusSnapshot();
+
+}
 
+/**
+  * Handlers for received commands, ordered as CommandHandler
+  */
+const IT100::CommandHandlerFn IT100::commandHandlers[HANDLER_COUNT] = {
+    nullptr,                            // HANDLER_NONE
+    &IT100::handleAcknowledge,          // HANDLER_ACKNOWLEDGE
+    &IT100::handleCommandError,         // HANDLER_COMMAND_ERROR
+    &IT100::handleZoneStatus,           // HANDLER_ZONE_STATUS
+    &IT100::handlePartitionStatus,      // HANDLER_PARTITION_STATUS
+    &IT100::handlePartitionArmed,       // HANDLER_PARTITION_ARMED
+    &IT100::handleUserClosing,          // HANDLER_USER_CLOSING
+    &IT100::handleSpecialClosing,       // HANDLER_SPECIAL_CLOSING
+    &IT100::handlePartialClosing,       // HANDLER_PARTIAL_CLOSING
+    &IT100::handleUserOpening,          // HANDLER_USER_OPENING
+    &IT100::handleInvalidAccessCode,    // HANDLER_INVALID_ACCESS_CODE
+    &IT100::handleLcdUpdate,            // HANDLER_LCD_UPDATE
+    &IT100::handleTrouble               // HANDLER_TROUBLE
+};
+
+// Decode a run of ASCII digits from payload; stops at the first non-digit
+static int payloadNumber(const LineView &payload, int from, int length = -1)
+{
+    int end = (length < 0) ? payload.size : qMin(payload.size, from + length);
+    int value = 0;
+    for (int i = from; i < end; i++) {
+        char c = payload.at(i);
+        if (c < '0' || c > '9') break;
+        value = value * 10 + (c - '0');
+    }
+    return value;
 }
 
 /**
   * processReceivedLine(data)
-  *
+  * Look up the 3-digit command in the command table and
+  * call its handler
   */
-int IT100::processReceivedLine(QByteArray data)
+int IT100::processReceivedLine(const LineView &line)
 {
 
     bool error = false;
 
     // Reject packets that are less than 5 chars
-    if (data.count() > 5) {
+    if (line.size < 5) {
+        error = true;
+
+    // Reject corrupt packets; the framer resyncs at the next CR/LF
+    } else if (!verifyChecksum(line.data, line.size)) {
+        error = true;
+        checksumRejects++;
+        if (_debugMode) qDebug() << qPrintable(QString("it100 -> bad checksum, dropped: %1")
+            .arg(QString::fromLatin1(line.data, line.size)));
+
+    } else {
 
         // update timeout timers
         pollTimer->start();
         communicationsTimeoutTimer->start();
-        lastReceivedCommsAt = lastReceivedCommsAt.currentDateTime();
-
-        // fyi - we are ignoring the checksum
-        QByteArray checksum = data.right(2);
-        QByteArray command = data.left(3);
-        QByteArray payload = data.mid(3,data.count() - 3 - 2);
-
-        if (_debugMode) qDebug() << qPrintable(QString("it100 -> %1 %2 %3")
-            .arg(QString(command))
-            .arg(QString(payload))
-            .arg(QString(checksum)));
-
-        // set system date & time
-        // hhmmMMDDYY
-        QDateTime datetime;
-        QString timestamp = datetime.currentDateTime().toString("dd-MMM-yyyy hh:mm:ss");
-
-        if (_debugMode && (command == CMD_COMMAND_ACKNOWLEDGE)) {
-            qDebug() << qPrintable(QString("it100 -> ACK")); }
-
-        if (command == CMD_COMMAND_ERROR) {
-            qDebug() << qPrintable(QString("it100 -> ERR: %1").arg(payload.data()));
-        }
-
-        // ###########################
-        // Discrete Zone Status Events
-        // ###########################
-
-        // Zone Open - no partition
-        if (command == CMD_ZONE_OPEN) {
-            int zone = payload.right(payload.length()-1).toInt();
-            emit zoneOpen(0,zone);
-            emit zoneStatusChanged(zone,0,ZONE_STATUS_OPEN);
-            if (_waitingForStatusUpdate && (zone == 64)) _waitingForStatusUpdate = false;
+        lastReceivedCommsAt = QDateTime::currentDateTime();
+        lineReceivedAt = lastReceivedCommsAt.toMSecsSinceEpoch();
+
+        const CommandInfo &info = commandInfo(parseCommandCode(line.data));
+        LineView payload = line.mid(3, line.size - 3 - 2);
+
+        if (_debugMode)
+            qDebug() << qPrintable(QString("it100 -> %1 %2 %3 (%4)")
+                .arg(QString::fromLatin1(line.data, 3))
+                .arg(QString::fromLatin1(payload.data, payload.size))
+                .arg(QString::fromLatin1(line.data + line.size - 2, 2))
+                .arg(info.name));
+
+        // handlers decode fixed offsets; a line of the wrong length is
+        // counted and not handled, though it still shows the link is up
+        if (info.payloadLength != PAYLOAD_VARIABLE &&
+                payload.size != info.payloadLength) {
+            lengthRejects++;
             if (_debugMode)
-                qDebug() << qPrintable(QString("%1: Zone %2 (%3) Open")
-                    .arg(timestamp).arg(zone)
-                    .arg(getZoneFriendlyName(zone)));
-        }
-
-        // Zone Close - no partition
-        if (command == CMD_ZONE_RESTORED) {
-            int zone = payload.right(payload.length()-1).toInt();
-            emit zoneRestored(0,zone); // fixme, change signal to not have partition as we dont know it
-            emit zoneStatusChanged(zone,0,ZONE_STATUS_RESTORED);
-            if (_waitingForStatusUpdate && (zone == 64)) _waitingForStatusUpdate = false;
-            if (_debugMode)
-                qDebug() << qPrintable(QString("%2: Zone %1 (%3) Restored")
-                    .arg(payload.data())
-                    .arg(timestamp)
-                    .arg(getZoneFriendlyName(zone)));
-        }
-
-        // Zone Tamper
-        if (command == CMD_ZONE_TAMPER) {
-            int partition = payload.left(1).toInt();
-            int zone = payload.right(payload.length()-1).toInt();
-            emit zoneStatusChanged(zone,partition,ZONE_STATUS_TAMPER);
-        }
-
-        // Zone Tamper Restore
-        if (command == CMD_ZONE_TAMPER_RESTORE) {
-            int partition = payload.left(1).toInt();
-            int zone = payload.right(payload.length()-1).toInt();
-            emit zoneStatusChanged(zone,partition,ZONE_STATUS_TAMPER_RESTORED);
-        }
-
-        // Zone Fault (no partition)
-        if (command == CMD_ZONE_FAULT) {
-            int zone = payload.right(payload.length()-1).toInt();
-            emit zoneStatusChanged(zone,0,ZONE_STATUS_FAULT);
-        }
-
-        // Zone Fault Restore - no partition
-        if (command == CMD_ZONE_FAULT_RESTORE) {
-            int zone = payload.right(payload.length()-1).toInt();
-            emit zoneStatusChanged(zone, 0, ZONE_STATUS_FAULT_RESTORED);
-        }
-
-        // Zone Alarm
-        if (command == CMD_ZONE_ALARM) {
-            int partition = data.mid(3,1).toInt();
-            int zone = data.mid(4,2).toInt();
-            emit zoneStatusChanged(zone, partition, ZONE_STATUS_ALARM);
-            // writeLog(QString("Partition %1, Zone %2 in ALARM ***").arg(partition).arg(zone), LOG_LEVEL_);
-        }
-
-        // Zone Alarm Restore
-        if (command == CMD_ZONE_ALARM_RESTORE) {
-            int partition = data.mid(3,1).toInt();
-            int zone = data.mid(4,2).toInt();
-            emit zoneStatusChanged(zone, partition, ZONE_STATUS_ALARM_RESTORED);
-            if (_debugMode)
-                qDebug() << qPrintable(QString("%1: *** Partition %2 alarm RESTORED ***")
-                    .arg(partition).arg(timestamp));
-        }
-
-        // ################
-        // Partition Events
-        // ################
-
-        // 652 Partition Armed; Data Bytes: 2; Partition 1-8, Mode.
-        // This command indicates that a partition has been armed and the mode
-        //  it has been armed in. This command is sent at the end of the 
-        //  exit-delay and after the Bell Cutoff expires.
-        //  Modes = 0 Away; 1 Stay; 2 Away, No Delay; 3 Stay, No Delay
-        if (command == CMD_PARTITION_ARMED_DESCRIPTIVE_MODE) {
-            
-            int partition = data.mid(3,1).toInt();
-            // int mode = static_cast<int>(data.mid(4,1).toInt());
-            PartitionArmedMode mode = static_cast<PartitionArmedMode>(data.mid(4,1).toInt());
-            
-            if (_debugMode)
-                qDebug() << qPrintable(QString("%1: Partition %2 Armed - Descriptive Mode (%3)")
-                    .arg(timestamp)
-                    .arg(partition)
-                    .arg(static_cast<int>(mode)));
-
-            emit partitionArmedDescriptive(partition, mode);
-        }
-
-        // 655 Partition Disarmed
-        if (command == CMD_PARTITION_DISARMED) {
-            int partition = data.mid(3,1).toInt();
-            emit partitionStatusChanged(partition, PARTITION_STATUS_DISARMED);
-            if (_debugMode)
-                qDebug() << qPrintable(QString("%1: Partition %2 Disarmed")
-                    .arg(timestamp)
-                    .arg(partition));
-        }
-
-        // 653 Partition is n Ready to "Force Arm" aka there is a zone violated
-        if (command == CMD_PARTITION_IN_READY_TO_FORCE_ALARM) {
-            int partition = data.mid(3,1).toInt();
-            emit partitionStatusChanged(partition, PARTITION_STATUS_READY_FORCE_ARM);
-            if (_debugMode) qDebug() << qPrintable(QString("%1: Partition %2 Ready to Force Arm")
-                .arg(timestamp)
-                .arg(partition));
-        }
-
-        if (command == CMD_PARTITION_IN_ALARM) {
-            int partition = data.mid(3,1).toInt();
-            emit partitionStatusChanged(partition, PARTITION_STATUS_ALARM);
-        }
-
-        if (command == CMD_PARTITION_READY) {
-            int partition = data.mid(3,1).toInt();
-            emit partitionStatusChanged(partition, PARTITION_STATUS_READY);
-        }
-
-        if (command == CMD_PARTITION_NOT_READY) {
-            int partition = data.mid(3,1).toInt();
-            emit partitionStatusChanged(partition, PARTITION_STATUS_NOT_READY);
+                qDebug() << qPrintable(QString("it100 -> %1 expected %2 data bytes, got %3; dropped")
+                    .arg(info.name)
+                    .arg(info.payloadLength)
+                    .arg(payload.size));
+        } else {
+            CommandHandlerFn handler = commandHandlers[info.handler];
+            if (handler) (this->*handler)(info, payload);
         }
+    }
 
-        // 673 Parttition Busy
-        if (command == CMD_PARTITION_BUSY) {
-            int partition = data.mid(3,1).toInt();
-            emit partitionStatusChanged(partition, PARTITION_STATUS_BUSY);
-        }
-
-        // 700 User Closing
-        // Partition has been armed by a user
-        //  - includes user code 0000 - 0042
-        if (command == CMD_USER_CLOSING) {
-            int partition = data.mid(3,1).toInt();
-            int user = data.mid(4,4).toInt();
-            emit userEvent(UserEventType::UserClosing,partition,user);
-            emit userClosing(partition,user);
-            emit partitionStatusChanged(partition, PARTITION_STATUS_USER_CLOSING);
-        }
-
-        // 701 Special Closing
-        // Partition has been armed by one of the following:
-        // Quick Arm, Auto Arm, Keyswitch, DLS Software, Wireless Key
-        if (command == CMD_SPECIAL_CLOSING) {
-            int partition = data.mid(3,1).toInt();
-            emit specialClosing(partition);
-        }
-
-        // 702 Partition Partial Closing
-        // Partition has been armed but one or more
-        // zones have been bypassed
-        if (command == CMD_PARTIAL_CLOSING) {
-            int partition = data.mid(3,1).toInt();
-            emit partialClosing(partition);
-            emit partitionStatusChanged(partition, PARTITION_STATUS_PARTIAL_CLOSING);
-        }
-
-        // 750 User Opening
-        // Partition has been disarmed by a user
-        if (command == CMD_USER_OPENING) {
-            int partition = data.mid(3,1).toInt();
-            int user = data.mid(4,4).toInt();
-            emit userEvent(UserEventType::UserOpening,partition,user);
-            emit userOpening(partition,user);
-        }
-
-        if (command == CMD_EXIT_DELAY_IN_PROGRESS) {
-            int partition = data.mid(3,1).toInt();
-            emit partitionStatusChanged(partition, PARTITION_STATUS_EXIT_DELAY_IN_PROGRESS);
-        }
-        if (command == CMD_ENTRY_DELAY_IN_PROGRESS) {
-            int partition = data.mid(3,1).toInt();
-            emit partitionStatusChanged(partition, PARTITION_STATUS_ENTRY_DELAY_IN_PROGRESS);
-        }
-
-        // Partition Special Closing
-        // Partition has been armed by one of following methods
-        // Quick Arm, Auto Arm, Keyswitch, DLS Software, or Wireless Key
-        if (command == CMD_SPECIAL_CLOSING) {
-            int partition = data.mid(3,1).toInt();
-            emit partitionStatusChanged(partition, PARTITION_STATUS_PARTIAL_CLOSING);
-            emit specialClosing(partition);
-        }
-
-        if (command == CMD_INVALID_ACCESS_CODE) {
-            int partition = data.mid(3,1).toInt();
-            emit userEvent(UserEventType::UserClosing,partition,-1);
-            emit invalidAccessCode(partition);
-            emit partitionStatusChanged(partition, PARTITION_STATUS_INVALID_ACCESS_CODE);
-        }
-
-        if (command == CMD_FUNCTION_NOT_AVAILABLE) {
-            int partition = data.mid(3,1).toInt();
-            emit partitionStatusChanged(partition, PARTITION_STATUS_FUNCTION_NOT_AVAILABLE);
-        }
-
-        if (command == CMD_LCD_UPDATE) {
-
-            // qDebug() << "CMD_LCD_UPDATE " << payload;
-            int lineNumber = payload.left(1).toInt();
-            int columnNumber = payload.mid(1,2).toInt();
-            int characters = payload.mid(3,2).toInt();
-            QString content = payload.right(payload.length()-5);
-
-            // TODO, account for character modifications vice line updates
-            // the condition below appears to be common whereas the it100
-            // calls for a wrapping 32 character screen update starting at
-            // line 0
-            if (lineNumber == 0 && content.length() == 32) {
-                lcdDisplayContents = content;
-                lcdDisplayContents.insert(16,"\r\n");
-            }
+    // Determine we have good communications so we can update our
+    // broker status.  This should be improved to take into account
+    // baud rate mismatches and garbage data.
+    if (!error && !communicationsGood) {
+        this->status = COMP_STATUS_OK;
+        emit communicationsBegin();
+        communicationsGood = true;
+    }
 
-            if (columnNumber != 0) qDebug() << "Character Mod Detected on LCD Display";
+    return !error;
 
-            emit virtualKeypadDisplayUpdate();
+}
 
+// 500 Command Acknowledge; Data Bytes: 3; the command being acknowledged
+void IT100::handleAcknowledge(const CommandInfo &info, const LineView &payload)
+{
+    Q_UNUSED(info)
+    int code = (payload.size >= 3) ? parseCommandCode(payload.data) : -1;
+
+    // the oldest command sent with this code is the one answered
+    int index = 0;
+    while (index < inFlightCount && inFlight[index].message.command() != code) index++;
+
+    bool awaited = index < inFlightCount;
+    uint64_t sequence = 0;
+    if (awaited) {
+        sequence = inFlight[index].sequence;
+        int rtt = static_cast<int>(linkClock.elapsed() - inFlight[index].sentAt);
+        linkStats.acknowledged++;
+        linkStats.rttLastMsecs = rtt;
+        if (linkStats.acknowledged == 1) {
+            linkStats.rttMinMsecs = linkStats.rttMaxMsecs = linkStats.rttAvgMsecs = rtt;
+        } else {
+            if (rtt < linkStats.rttMinMsecs) linkStats.rttMinMsecs = rtt;
+            if (rtt > linkStats.rttMaxMsecs) linkStats.rttMaxMsecs = rtt;
+            linkStats.rttAvgMsecs += (rtt - linkStats.rttAvgMsecs) / 8;
         }
+        if (_debugMode) qDebug() << qPrintable(QString("it100 -> ACK %1 (%2 ms)")
+            .arg(code, 3, 10, QChar('0')).arg(rtt));
+        removeInFlight(index);
+        writePacket();
+        if (code == CMD_KEY_PRESSED_VIRT && keyAwaitingAck) onKeyAcknowledged();
+    } else {
+        linkStats.unmatchedAcks++;
+        if (_debugMode) qDebug() << qPrintable(QString("it100 -> ACK %1, not awaited")
+            .arg(QString::fromLatin1(payload.data, payload.size)));
+    }
 
-        // TROUBLE EVENTS
-
-        if (command == CMD_PANEL_AC_TROUBLE)
-            emit troubleEvent(TROUBLE_PANEL_AC);
-
-        if (command == CMD_PANEL_AC_RESTORE)
-            emit troubleEvent(TROUBLE_PANEL_AC_RESTORE);
-
-        if (command == CMD_PANEL_BATTERY_TROUBLE)
-            emit troubleEvent(TROUBLE_PANEL_BATTERY);
-
-        if (command == CMD_PANEL_BATTERY_TROUBLE_RESTORE)
-            emit troubleEvent(TROUBLE_PANEL_BATTERY_RESTORE);
-
-        if (command == CMD_SYSTEM_BELL_TROUBLE)
-            emit troubleEvent(TROUBLE_SYSTEM_BELL);
+    if (!_waitingForStatusUpdate || !awaited) return;
+
+    // the status flood follows the acknowledgement of our 001, and the
+    // acknowledgement of a poll sent after it follows the flood. A poll
+    // first sent before the 001 was answered does not count
+    if (code == CMD_STATUS_REQUEST && !snapshotAcknowledged) {
+        snapshotAcknowledged = true;
+        snapshotMarkerSequence = commandSequence;
+        sendCommand(CMD_POLL);
+    } else if (code == CMD_POLL && snapshotAcknowledged &&
+               sequence >= snapshotMarkerSequence) {
+        endStatusSnapshot(true);
+    }
+}
 
-        if (command == CMD_SYSTEM_BELL_TROUBLE_RESTORAL)
-            emit troubleEvent(TROUBLE_SYSTEM_BELL_RESTORE);
+// 501 Command Error; the panel could not take a command, usually for a
+// bad checksum. It does not say which, so the oldest is sent again
+void IT100::handleCommandError(const CommandInfo &info, const LineView &payload)
+{
+    Q_UNUSED(info)
+    qDebug() << qPrintable(QString("it100 -> ERR: %1")
+        .arg(QString::fromLatin1(payload.data, payload.size)));
 
-        if (command == CMD_TLM_LINE_1_TROUBLE)
-            emit troubleEvent(TROUBLE_TLM_1);
+    linkStats.errors++;
+    if (inFlightCount) {
+        retryInFlight(0);
+        writePacket();
+    }
+}
 
-        if (command == CMD_TLM_LINE_1_TROUBLE_RESTORAL)
-            emit troubleEvent(TROUBLE_TLM_1_RESTORE);
+// ###########################
+// Discrete Zone Status Events
+// ###########################
 
-        if (command == CMD_TLM_LINE_2_TROUBLE)
-            emit troubleEvent(TROUBLE_TLM_2);
+// 601-604 carry partition + 3 digit zone; 605, 606, 609 and 610 carry
+// the zone only as the partition is not known
+void IT100::handleZoneStatus(const CommandInfo &info, const LineView &payload)
+{
+    PanelEvent event = newEvent(info, PanelEvent::Zone);
+    event.status = info.arg;
 
-        if (command == CMD_TLM_LINE_2_TROUBLE_RESTORAL)
-            emit troubleEvent(TROUBLE_TLM_2_RESTORE);
+    if (payload.size > 3) {
+        event.partition = payloadNumber(payload, 0, 1);
+        event.zone = payloadNumber(payload, 1);
+    } else {
+        event.zone = payloadNumber(payload, 0);
+    }
 
-        if (command == CMD_FTC_TROUBLE)
-            emit troubleEvent(TROUBLE_FTC);
+    if (_debugMode)
+        qDebug() << qPrintable(QString("%1: Partition %2, Zone %3 (%4) %5")
+            .arg(QDateTime::currentDateTime().toString("dd-MMM-yyyy hh:mm:ss"))
+            .arg(event.partition)
+            .arg(event.zone)
+            .arg(getZoneFriendlyName(event.zone))
+            .arg(info.name));
 
-        if (command == CMD_BUFFER_NEAR_FULL)
-            emit troubleEvent(TROUBLE_BUFFER_NEAR_FULL);
+    dispatchEvent(event);
+}
 
-        if (command == CMD_GENERAL_DEVICE_LOW_BATTERY)
-            emit troubleEvent(TROUBLE_GENERAL_DEVICE_LOW_BATTERY);
+// ################
+// Partition Events
+// ################
 
-        if (command == CMD_GENERAL_DEVICE_LOW_BATTERY_RESTORE)
-            emit troubleEvent(TROUBLE_GENERAL_DEVICE_LOW_BATTERY_RESTORE);
+void IT100::handlePartitionStatus(const CommandInfo &info, const LineView &payload)
+{
+    PanelEvent event = newEvent(info, PanelEvent::Partition);
+    event.partition = payloadNumber(payload, 0, 1);
+    event.status = info.arg;
+    if (_debugMode)
+        qDebug() << qPrintable(QString("%1: Partition %2 %3")
+            .arg(QDateTime::currentDateTime().toString("dd-MMM-yyyy hh:mm:ss"))
+            .arg(event.partition)
+            .arg(info.name));
+    dispatchEvent(event);
+}
 
-        if (command == CMD_GENERAL_SYSTEM_TAMPER)
-            emit troubleEvent(TROUBLE_GENERAL_SYSTEM_TAMPER);
+// 652 Partition Armed; Data Bytes: 2; Partition 1-8, Mode.
+// This command indicates that a partition has been armed and the mode
+//  it has been armed in. This command is sent at the end of the
+//  exit-delay and after the Bell Cutoff expires.
+//  Modes = 0 Away; 1 Stay; 2 Away, No Delay; 3 Stay, No Delay
+void IT100::handlePartitionArmed(const CommandInfo &info, const LineView &payload)
+{
+    PanelEvent event = newEvent(info, PanelEvent::PartitionArmed);
+    event.partition = payloadNumber(payload, 0, 1);
+    event.status = payloadNumber(payload, 1, 1);
 
-        if (command == CMD_GENERAL_SYSTEM_TAMPER_RESTORE)
-            emit troubleEvent(TROUBLE_GENERAL_SYSTEM_TAMPER_RESTORE);
+    if (_debugMode)
+        qDebug() << qPrintable(QString("%1: Partition %2 Armed - Descriptive Mode (%3)")
+            .arg(QDateTime::currentDateTime().toString("dd-MMM-yyyy hh:mm:ss"))
+            .arg(event.partition)
+            .arg(event.status));
 
-        if (command == CMD_WIRELESS_KEY_LOW_BATTERY_TROUBLE)
-            emit troubleEvent(TROUBLE_WIRELESS_KEY_LOW_BATTERY);
+    dispatchEvent(event);
+}
 
-        if (command == CMD_WIRELESS_KEY_LOW_BATTERY_TROUBLE_RESTORE)
-            emit troubleEvent(TROUBLE_WIRELESS_KEY_LOW_BATTERY_RESTORE);
+// 700 User Closing
+// Partition has been armed by a user
+//  - includes user code 0000 - 0042
+void IT100::handleUserClosing(const CommandInfo &info, const LineView &payload)
+{
+    PanelEvent event = newEvent(info, PanelEvent::User);
+    event.partition = payloadNumber(payload, 0, 1);
+    event.user = payloadNumber(payload, 1, 4);
+    event.status = UserClosing;
+    dispatchEvent(event);
+}
 
-        if (command == CMD_HANDHELD_KEYPAD_LOW_BATTERY_TROUBLE)
-            emit troubleEvent(TROUBLE_HANDHELD_KEYPAD_LOW_BATTERY);
+// 701 Special Closing
+// Partition has been armed by one of the following:
+// Quick Arm, Auto Arm, Keyswitch, DLS Software, Wireless Key
+void IT100::handleSpecialClosing(const CommandInfo &info, const LineView &payload)
+{
+    PanelEvent event = newEvent(info, PanelEvent::Partition);
+    event.partition = payloadNumber(payload, 0, 1);
+    event.status = PARTITION_STATUS_SPECIAL_CLOSING;
+    dispatchEvent(event);
+}
 
-        if (command == CMD_HANDHELD_KEYPAD_LOW_BATTERY_TROUBLE_RESTORE)
-            emit troubleEvent(TROUBLE_HANDHELD_KEYPAD_LOW_BATTERY_RESTORE);
+// 702 Partition Partial Closing
+// Partition has been armed but one or more
+// zones have been bypassed
+void IT100::handlePartialClosing(const CommandInfo &info, const LineView &payload)
+{
+    PanelEvent event = newEvent(info, PanelEvent::Partition);
+    event.partition = payloadNumber(payload, 0, 1);
+    event.status = PARTITION_STATUS_PARTIAL_CLOSING;
+    dispatchEvent(event);
+}
 
-        if (command == CMD_HOME_AUTOMATION_TROUBLE)
-            emit troubleEvent(TROUBLE_HOME_AUTOMATION);
+// 750 User Opening
+// Partition has been disarmed by a user
+void IT100::handleUserOpening(const CommandInfo &info, const LineView &payload)
+{
+    PanelEvent event = newEvent(info, PanelEvent::User);
+    event.partition = payloadNumber(payload, 0, 1);
+    event.user = payloadNumber(payload, 1, 4);
+    event.status = UserOpening;
+    dispatchEvent(event);
+}
 
-        if (command == CMD_HOME_AUTOMATION_TROUBLE_RESTORE)
-            emit troubleEvent(TROUBLE_HOME_AUTOMATION_RESTORE);
+// 670 Invalid Access Code
+// No user is reported
+void IT100::handleInvalidAccessCode(const CommandInfo &info, const LineView &payload)
+{
+    PanelEvent event = newEvent(info, PanelEvent::User);
+    event.partition = payloadNumber(payload, 0, 1);
+    event.status = UserInvalidAccessCode;
+    dispatchEvent(event);
+}
 
-    } else {
-        error = true;
+void IT100::handleLcdUpdate(const CommandInfo &info, const LineView &payload)
+{
+    int lineNumber = payloadNumber(payload, 0, 1);
+    int columnNumber = payloadNumber(payload, 1, 2);
+    LineView text = payload.mid(5);
+    QString content = QString::fromLatin1(text.data, text.size);
+
+    // TODO, account for character modifications vice line updates
+    // the condition below appears to be common whereas the it100
+    // calls for a wrapping 32 character screen update starting at
+    // line 0
+    if (lineNumber == 0 && content.length() == 32) {
+        lcdDisplayContents = content;
+        lcdDisplayContents.insert(16,"\r\n");
     }
 
-    // Determine we have good communications so we can update our
-    // broker status.  This should be improved to take into account
-    // baud rate mismatches and garbage data.
-    if (!error && !communicationsGood) {
-        this->status = COMP_STATUS_OK;
-        emit communicationsBegin();
-        communicationsGood = true;
-    }
+    if (columnNumber != 0) qDebug() << "Character Mod Detected on LCD Display";
 
-    // In the game of ping pong, we can now consider ourselves to not be waiting
-    // for a message to return
-    // albeit certain commands result in a flood of return messages such
-    // as the status request
-    writePacket();
+    dispatchEvent(newEvent(info, PanelEvent::KeypadDisplay));
+}
 
-    return !error;
+// TROUBLE EVENTS
+void IT100::handleTrouble(const CommandInfo &info, const LineView &payload)
+{
+    Q_UNUSED(payload)
+    PanelEvent event = newEvent(info, PanelEvent::Trouble);
+    event.status = info.arg;
+    dispatchEvent(event);
+}
 
+// Event for the line being processed with nothing decoded yet
+PanelEvent IT100::newEvent(const CommandInfo &info, PanelEvent::Type type)
+{
+    PanelEvent event;
+    event.code = info.code;
+    event.type = type;
+    event.partition = 0;
+    event.zone = 0;
+    event.status = 0;
+    event.user = -1;
+    event.receivedAt = lineReceivedAt;
+    return event;
 }
 
+void IT100::dispatchEvent(const PanelEvent &event)
+{
+    if (eventConsumer) eventConsumer->onPanelEvent(event);
+}
 
 /**
   * onPollTimer()
@@ -526,6 +539,45 @@ bool IT100::isWaitingForStatusUpdate()
     return _waitingForStatusUpdate;
 }
 
+/**
+  * requestStatusSnapshot()
+  * Ask the panel for the state of every zone and partition.
+  * Events until the consumer is told the snapshot is complete are
+  * the response rather than live changes
+  */
+void IT100::requestStatusSnapshot()
+{
+    if (_waitingForStatusUpdate) return;
+
+    _waitingForStatusUpdate = true;
+    snapshotAcknowledged = false;
+    snapshotElapsed.start();
+    snapshotTimeoutTimer->start();
+    if (eventConsumer) eventConsumer->onSnapshotBegin();
+
+    sendCommand(CMD_STATUS_REQUEST);
+}
+
+void IT100::endStatusSnapshot(bool complete)
+{
+    snapshotTimeoutTimer->stop();
+    _waitingForStatusUpdate = false;
+    snapshotAcknowledged = false;
+
+    int64_t elapsed = snapshotElapsed.elapsed();
+    if (_debugMode)
+        qDebug() << qPrintable(QString("status snapshot %1 after %2 ms")
+            .arg(complete ? "complete" : "incomplete")
+            .arg(elapsed));
+
+    if (eventConsumer) eventConsumer->onSnapshotComplete(elapsed, complete);
+}
+
+void IT100::onSnapshotTimeoutTimerTimeout()
+{
+    if (_waitingForStatusUpdate) endStatusSnapshot(false);
+}
+
 // convert enum class IT100:UserEventType to string
 QString IT100::userEventTypeToString(UserEventType type)
 {
@@ -560,116 +612,172 @@ void IT100::onCommunicationsTimeoutTimerTimeout()
     }
 }
 
-// this method is called every it100TcpConnecionRetryTimeSeconds * 1000ms
-// until connected - never give up!
-void IT100::processModuleReconnectTimerTimeout()
-{
-    this->open();
-}
-
 /**
-  * generateDscChecksum
-  * Produce DSC style 2 byte checksum
-  * Input is command+data bytes
-  * Can be used for packet generation + verification
+  * Send Command to DSC IT-100 Module
+  * Basically a wrapper, to allow for abstraction
   */
-QByteArray IT100::generateChecksum(QByteArray data)
-{
-    /* Count up HEX (as int) bytes */
-    QString hexint = QString(data.toHex());
-    int count = 0;
-    for (int x = 0; x < data.size(); x++) {
-        // hexint = QString(QByteArray(status.at(x)).toHex());
-        bool ok;
-        count += hexint.mid((x * 2),2).toUInt(&ok,16);
+bool IT100::sendCommand(Command command, QByteArray data)
+{
+    CommandLane lane = commandLane(command);
+    CommandQueue &queue = commandLanes[lane];
+
+    // Format the packet straight into the queue for its lane
+    It100Message message(command, data);
+    bool queued = (lane == LANE_HOUSEKEEPING)
+            ? queue.pushCoalesced(message, linkClock.elapsed())
+            : queue.push(message, linkClock.elapsed());
+    if (!queued) {
+        qDebug() << qPrintable(QString("command %1 not queued: %2")
+            .arg(static_cast<int>(command))
+            .arg(message.isValid() ? "queue full" : "data too long"));
+        return false;
     }
 
-    /* Convert number (int) to HEX Ascii for chopping up */
-    QString asciiint = QString().setNum(count,16);
-
-    // QByteArray checksum = QByteArray().fromHex();
-    // TODO, still need to truncate this to 8 bits!
-
-    /* create silly checksum */
-    QByteArray checksum;
-    checksum.append(asciiint.mid(asciiint.size()-2,1).toUpper());
-    checksum.append(asciiint.mid(asciiint.size()-1,1).toUpper());
+    // Force the message along if the window has room
+    if (isConnected()) writePacket();
+    return true;
+}
 
-    return checksum;
+bool IT100::sendCommand(Command command, uint16_t data)
+{
+    return sendCommand(command,QByteArray::number(data));
+}
 
+bool IT100::sendCommand(Command command)
+{
+    return sendCommand(command,QByteArray());
 }
 
-/**
-  * generatePacket(command,data)
-  * Accept DSC command and data bytes
-  * generate checksum, and append CR/LF
-  */
-QByteArray IT100::generatePacket(QByteArray command, QByteArray data = "")
+// Write packets while the window has room, always from the
+// highest priority lane holding one, no faster than the serial line
+// Sent commands are held in flight until acknowledged
+//
+void IT100::writePacket()
 {
-    /* Start off packet with command */
-    QByteArray packet = command;
+    // held in the lanes until the link is back; a transport that just
+    // failed is closed before its queued disconnected() arrives
+    if (!isConnected() || !transport->isOpen()) return;
+
+    while (inFlightCount < commandWindow && !transmitPacingTimer->isActive()) {
+        int lane = 0;
+        while (lane < LANE_COUNT && commandLanes[lane].isEmpty()) lane++;
+        if (lane == LANE_COUNT) break;
+
+        int delay = 0;
+        if (!pacer.tryConsume(commandLanes[lane].front().size(),
+                              linkClock.elapsed(), &delay)) {
+            transmitPacingTimer->start(delay);
+            break;
+        }
 
-    /* Append data */
-    if (data.size()>0) packet.append(data);
+        InFlightCommand &command = inFlight[inFlightCount++];
+        command.message = commandLanes[lane].take(linkClock.elapsed());
+        command.sequence = commandSequence++;
+        command.attempts = 0;
 
-    /* Append calculated checksum from current payload */
-    packet.append(generateChecksum(packet));
+        // the transport failed; the link down that follows clears the window
+        if (!transmit(command)) break;
+    }
+    armCommandDeadline();
+}
 
-    /* Append token EOL */
-    packet.append("\r\n");
+// Commands whose data is, or may spell out, an access code
+static bool carriesAccessCode(Command command)
+{
+    return command == CMD_PARTITION_ARM_CONTROL_WITH_CODE ||
+            command == CMD_PARTITION_DISARM_CONTROL_WITH_CODE ||
+            command == CMD_CODE_SEND ||
+            command == CMD_KEY_PRESSED_VIRT;
+}
 
-    return packet;
+// Line time is taken from the pacer by the caller
+// False if the transport would not take it
+bool IT100::transmit(InFlightCommand &command)
+{
+    const It100Message &message = command.message;
+    if (_debugMode) {
+        QString packet = carriesAccessCode(message.command())
+                ? QString("%1 (data withheld)")
+                  .arg(static_cast<int>(message.command()), 3, 10, QChar('0'))
+                : QString::fromLatin1(message.packet(), message.size() - 2);
+        qDebug() << qPrintable(QString("wrote: %1").arg(packet));
+    }
+    command.sentAt = linkClock.elapsed();
+    command.attempts++;
+    if (transport->write(message.packet(), message.size()) < 0) return false;
+    linkStats.sent++;
+    return true;
 }
 
+void IT100::removeInFlight(int index)
+{
+    for (int i = index + 1; i < inFlightCount; i++) inFlight[i - 1] = inFlight[i];
+    inFlightCount--;
+}
 
+// Send again, or give up on it after commandMaxAttempts
+void IT100::retryInFlight(int index)
+{
+    InFlightCommand &command = inFlight[index];
+    if (command.attempts < commandMaxAttempts) {
+        linkStats.retransmits++;
+        pacer.consume(command.message.size(), linkClock.elapsed());
+        transmit(command);
+    } else {
+        linkStats.abandoned++;
+        Command code = command.message.command();
+        qDebug() << qPrintable(QString("command %1 abandoned after %2 attempts")
+            .arg(static_cast<int>(code), 3, 10, QChar('0'))
+            .arg(command.attempts));
+        removeInFlight(index);
+
+        // the sequence is timed from acknowledgements that will not come
+        if (code == CMD_KEY_PRESSED_VIRT && keyAwaitingAck) endKeySequence(false);
+    }
+}
 
-/**
-  * Send Command to DSC IT-100 Module
-  * Basically a wrapper, to allow for abstraction
-  */
-void IT100::sendCommand(QByteArray command, QByteArray data)
+void IT100::armCommandDeadline()
 {
-    // Create IT100 Message
-    It100Message *message = new It100Message(command,data);
+    if (!inFlightCount) {
+        commandDeadlineTimer->stop();
+        return;
+    }
 
-    // Append message to queue
-    messageQueueOut.append(message);
+    int64_t oldest = inFlight[0].sentAt;
+    for (int i = 1; i < inFlightCount; i++)
+        if (inFlight[i].sentAt < oldest) oldest = inFlight[i].sentAt;
 
-    // Force the message along if the conditions are right
-    if (isConnected() && !waitingForResponse)
-        writePacket();
+    int64_t remaining = oldest + commandAckTimeoutMsecs - linkClock.elapsed();
+    commandDeadlineTimer->start(static_cast<int>(qMax<int64_t>(remaining, 0)));
+}
 
+void IT100::onCommandDeadlineTimerTimeout()
+{
+    int64_t now = linkClock.elapsed();
+    int i = 0;
+    while (i < inFlightCount) {
+        int count = inFlightCount;
+        if (now - inFlight[i].sentAt >= commandAckTimeoutMsecs) retryInFlight(i);
+        if (inFlightCount == count) i++;
+    }
+    writePacket();
 }
 
-void IT100::sendCommand(QByteArray command, uint16_t data)
+// Commands in flight are not answered on a new connection
+void IT100::clearInFlight()
 {
-    sendCommand(command,QByteArray::number(data));
+    inFlightCount = 0;
+    commandDeadlineTimer->stop();
 }
 
-void IT100::sendCommand(QByteArray command)
+void IT100::setCommandOverflowPolicy(CommandQueue::OverflowPolicy policy)
 {
-    sendCommand(command,QByteArray());
+    for (CommandQueue &queue : commandLanes) queue.setOverflowPolicy(policy);
 }
 
-// Write packet from queue
-// remove last message
-//
-// possible improvement would be to leave the last message
-// in the queue for cases of re-send
-//
-void IT100::writePacket()
+void IT100::setCommandWindow(int size)
 {
-    waitingForResponse = false;
-    if (messageQueueOut.count()) {
-        if (_debugMode) {
-            QString debugMsg = QString::fromUtf8(*messageQueueOut.at(0)->packet());
-            if (debugMsg.endsWith("\r\n")) debugMsg.truncate(debugMsg.count()-2);
-            qDebug() << qPrintable(QString("wrote: %1").arg(debugMsg));
-        }
-        socket->write(messageQueueOut.at(0)->packet()->data());
-        messageQueueOut.removeAt(0);
-        waitingForResponse = true;
-    }
+    commandWindow = qBound(1, size, maxCommandWindow);
 }
 
 /**
@@ -694,81 +802,36 @@ QString IT100::getZoneFriendlyName(int zoneNumber)
         return QString("undefined");
 }
 
-void IT100::processTcpSocketStateChange(QAbstractSocket::SocketState state)
-{
-    switch (state) {
-    case QAbstractSocket::HostLookupState:
-        break;
-
-    case QAbstractSocket::ConnectingState:
-        if (_debugMode) qDebug() << qPrintable(
-            QString("connecting to it100 %1 tcp/%2")
-                .arg(remoteHostAddress.toString())
-                .arg(QString::number(remoteHostPort)));
-        break;
-
-    case QAbstractSocket::ConnectedState:
-        _connected = true;
-        _connectionAttempts = 0;
-        waitingForResponse = false; // need to get things going again
-        processTcpSocketConnected();
-        emit connected();
-        qDebug() << qPrintable(QString("connected to it100 %1 tcp/%2")
-            .arg(remoteHostAddress.toString())
-            .arg(QString::number(remoteHostPort)));
-        break;
-
-    case QAbstractSocket::UnconnectedState:
-
-        // Maintain state tracking
-        _connected = false;
-        communicationsGood = false;
-        emit disconnected();
-        qDebug() << qPrintable(QString("ERROR: disconnected from %1:%2")
-            .arg(remoteHostAddress.toString())
-            .arg(QString::number(remoteHostPort)));
-
-        // begin reconnect process if disconnect was unexpected
-        // who are we kidding, there is no disconnect method anyways
-        // try immediately first, then enter a cycling reconnect timer
-        if (_connectionIntent) {
-            if (!_connectionAttempts) {
-                if (_debugMode) qDebug() << "attempting reconnect";
-                open();
-            }
-            else { // start connection retry timer
-                if (_connectionAttempts == 1)
-                    if (_debugMode) qDebug() << qPrintable(
-                        QString("starting reconnect timer; every %1 seconds")
-                            .arg(3));
-                QTimer::singleShot(socketConnectRetrySecs * 1000,
-                    this, SLOT(on_moduleReconnectTimerTimeout()));
-            }
-        }
-
-        break;
-    default:
-        qDebug() << state;
-        break;
-    }
-
-}
-
-// Connection Retry Delay Period has expired
-// attempt another connection
-void IT100::processTcpConnectRetryTimeout()
+void IT100::processLinkUp()
 {
-    open();
-}
-
-void IT100::setRemoteHostAddress(QHostAddress address)
-{
-    remoteHostAddress = address;
+    _connected = true;
+    linkSupervisor->linkUp();
+    clearInFlight(); // need to get things going again
+    processTcpSocketConnected();
+    emit connected();
+    qDebug() << qPrintable(QString("connected to it100 %1").arg(linkName()));
+
+    // commands queued while the link was down
+    writePacket();
 }
 
-void IT100::setRemoteHostPort(uint16_t port)
+void IT100::processLinkDown()
 {
-    remoteHostPort = port;
+    // Maintain state tracking
+    _connected = false;
+    communicationsGood = false;
+    framer.clear();
+    clearInFlight();
+    transmitPacingTimer->stop();
+    if (_waitingForStatusUpdate) endStatusSnapshot(false);
+    if (isKeySequenceActive()) endKeySequence(false);
+    emit disconnected();
+    qDebug() << qPrintable(QString("ERROR: disconnected from %1 (%2)")
+        .arg(linkName())
+        .arg(transport->errorString()));
+
+    // retry immediately first, then back off
+    linkSupervisor->linkDown();
 }
 
 void IT100::armAway(int partition)
@@ -789,7 +852,6 @@ void IT100::disarm(int partition)
     for(int i = code.length(); i < 6; i++) code.append("0"); // padd zeros to 6 digits
     sendCommand(it100::CMD_PARTITION_DISARM_CONTROL_WITH_CODE,
         QByteArray::number(partition).append(code));
-    qDebug() << "code is " << code;
 }
 
 void IT100::setEnableVirtualKeypad(bool value)
@@ -798,5 +860,92 @@ void IT100::setEnableVirtualKeypad(bool value)
                 static_cast<uint16_t>(value));
 }
 
-} // namespace it100
+// Keys the virtual keypad accepts
+// 0-9, *, #, <, >, a-e (function keys), F, A, P (fire, aux, panic)
+static bool isKeypadKey(char key)
+{
+    return (key >= '0' && key <= '9') ||
+            key == '*' || key == '#' || key == '<' || key == '>' ||
+            (key >= 'a' && key <= 'e') ||
+            key == 'F' || key == 'A' || key == 'P';
+}
+
+/**
+  * sendKeySequence(keys)
+  * Queue a keypress and keybreak for each key, paced by
+  * keySequenceTimer; keyLongPressMarker after a key holds it for
+  * keyLongPressMsecs, as some keypad functions require. Each hold and
+  * gap starts when the panel acknowledges the key or keybreak, so
+  * waiting in the lanes or on the serial line does not shorten it
+  */
+bool IT100::sendKeySequence(const QByteArray &keys)
+{
+    if (isKeySequenceActive()) return false;
+    if (keys.isEmpty() || keys.size() > maxKeySequenceLength) return false;
+
+    for (int i = 0; i < keys.size(); i++) {
+        if (keys.at(i) == keyLongPressMarker) {
+            if (i == 0 || keys.at(i - 1) == keyLongPressMarker) return false;
+        } else if (!isKeypadKey(keys.at(i))) {
+            return false;
+        }
+    }
 
+    keySequence = keys;
+    keySequencePos = 0;
+    keySequenceKeys = 0;
+    keyDown = false;
+    onKeySequenceTimerTimeout();
+    return true;
+}
+
+void IT100::onKeySequenceTimerTimeout()
+{
+    keyAwaitingAck = true;
+
+    if (keyDown) {
+        // release the key pressed by the last step
+        keyDown = false;
+        keyStepMsecs = keyGapMsecs;
+        if (!sendCommand(CMD_KEY_PRESSED_VIRT, QByteArray("^"))) endKeySequence(false);
+        return;
+    }
+
+    char key = keySequence.at(keySequencePos++);
+    bool longPress = keySequencePos < keySequence.size() &&
+            keySequence.at(keySequencePos) == keyLongPressMarker;
+    if (longPress) keySequencePos++;
+
+    keySequenceKeys++;
+    keyDown = true;
+    keyStepMsecs = longPress ? keyLongPressMsecs : keyPressMsecs;
+    if (!sendCommand(CMD_KEY_PRESSED_VIRT, QByteArray(1, key))) {
+        keySequenceKeys--;
+        keyDown = false;
+        endKeySequence(false);
+    }
+}
+
+// The key or keybreak just sent is in; hold it, or leave the gap
+void IT100::onKeyAcknowledged()
+{
+    keyAwaitingAck = false;
+    if (!keyDown && keySequencePos >= keySequence.size())
+        endKeySequence(true);
+    else
+        keySequenceTimer->start(keyStepMsecs);
+}
+
+void IT100::endKeySequence(bool complete)
+{
+    keySequenceTimer->stop();
+    keySequence.clear();
+    keyAwaitingAck = false;
+
+    // never leave a key held down
+    if (keyDown) sendCommand(CMD_KEY_PRESSED_VIRT, QByteArray("^"));
+    keyDown = false;
+    emit keySequenceComplete(keySequenceKeys, complete);
+}
+
+} // namespace it100
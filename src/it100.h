@@ -3,6 +3,7 @@
 
 #include <QDateTime>
 #include <QTimer>
+#include <QElapsedTimer>
 
 #include <QtNetwork>
 
@@ -11,81 +12,41 @@
 #include <QDateTime>
 
 #include "it100message.h"
+#include "it100commandqueue.h"
+#include "it100pacer.h"
+#include "it100transport.h"
+#include "it100commands.h"
+#include "it100framer.h"
+#include "it100event.h"
 #include "commonservice.h"
+#include "connectionsupervisor.h"
 
 namespace it100 {
 
 Q_NAMESPACE
 
 inline static const int socketDataReceiveTimeoutSecs = 30;
-inline static const int socketConnectRetrySecs = 5;
 
-enum InterfaceType {
-    IFACE_RS232 = 0,
-    IFACE_IPSERIAL = 1
-};
-
-enum ZoneStatus {
-    ZONE_STATUS_OPEN,
-    ZONE_STATUS_RESTORED,
-    ZONE_STATUS_TAMPER,
-    ZONE_STATUS_TAMPER_RESTORED,
-    ZONE_STATUS_FAULT,
-    ZONE_STATUS_FAULT_RESTORED,
-    ZONE_STATUS_ALARM,
-    ZONE_STATUS_ALARM_RESTORED
-};
-
-
-enum PartitionStatus {
-    PARTITION_STATUS_ARMED,
-    PARTITION_STATUS_DISARMED,
-    PARTITION_STATUS_ALARM,
-    PARTITION_STATUS_RESTORE,
-    PARTITION_STATUS_READY,
-    PARTITION_STATUS_NOT_READY,
-    PARTITION_STATUS_READY_FORCE_ARM,
-    PARTITION_STATUS_EXIT_DELAY_IN_PROGRESS,
-    PARTITION_STATUS_ENTRY_DELAY_IN_PROGRESS,
-    PARTITION_STATUS_USER_CLOSING,
-    PARTITION_STATUS_PARTIAL_CLOSING,
-    PARTITION_STATUS_SPECIAL_CLOSING,
-    PARTITION_STATUS_INVALID_ACCESS_CODE,
-    PARTITION_STATUS_FUNCTION_NOT_AVAILABLE,
-    PARTITION_STATUS_BUSY
-};
-
-enum PartitionArmedMode {
-    PARTITION_ARMED_AWAY = 0,
-    PARTITION_ARMED_STAY = 1,
-    PARTITION_ARMED_AWAY_NODELAY = 2,
-    PARTITION_ARMED_STAY_NODELAY = 3
-};
-
-enum TroubleEvent {
-    TROUBLE_PANEL_BATTERY,
-    TROUBLE_PANEL_BATTERY_RESTORE,
-    TROUBLE_PANEL_AC,
-    TROUBLE_PANEL_AC_RESTORE,
-    TROUBLE_SYSTEM_BELL,
-    TROUBLE_SYSTEM_BELL_RESTORE,
-    TROUBLE_TLM_1,
-    TROUBLE_TLM_1_RESTORE,
-    TROUBLE_TLM_2,
-    TROUBLE_TLM_2_RESTORE,
-    TROUBLE_FTC,
-    TROUBLE_BUFFER_NEAR_FULL,
-    TROUBLE_GENERAL_DEVICE_LOW_BATTERY,
-    TROUBLE_GENERAL_DEVICE_LOW_BATTERY_RESTORE,
-    TROUBLE_GENERAL_SYSTEM_TAMPER,
-    TROUBLE_GENERAL_SYSTEM_TAMPER_RESTORE,
-    TROUBLE_WIRELESS_KEY_LOW_BATTERY,
-    TROUBLE_WIRELESS_KEY_LOW_BATTERY_RESTORE,
-    TROUBLE_HANDHELD_KEYPAD_LOW_BATTERY,
-    TROUBLE_HANDHELD_KEYPAD_LOW_BATTERY_RESTORE,
-    TROUBLE_HOME_AUTOMATION,
-    TROUBLE_HOME_AUTOMATION_RESTORE
-};
+// The response to a status request has no end marker of its own. A poll
+// is sent once the panel acknowledges the 001; as the panel answers
+// commands in order, the acknowledgement of that poll follows the last
+// status line
+inline static const int statusSnapshotTimeoutSecs = 15;
+
+// Each command sent is held until the panel answers it with a 500
+// carrying its code; a 501 or no answer in time sends it again
+inline static const int commandAckTimeoutMsecs = 2000;
+inline static const int commandMaxAttempts = 3;
+inline static const int maxCommandWindow = 8;
+
+// Virtual keypad pacing, timed from the panel's acknowledgement of each
+// key and keybreak; a long press (key followed by keyLongPressMarker)
+// holds the key before its keybreak
+inline static const int keyPressMsecs = 50;
+inline static const int keyLongPressMsecs = 1600;
+inline static const int keyGapMsecs = 150;
+inline static const int maxKeySequenceLength = 64;
+inline static const char keyLongPressMarker = '~';
 
 // these correspond to various it100 based commands
 enum UserEventType {
@@ -101,13 +62,13 @@ class IT100 : public QObject
     Q_OBJECT
 public:
     
-    IT100(InterfaceType interfaceType, bool debugMode = false);
+    explicit IT100(bool debugMode = false);
 
     ComponentStatus getStatus() { return status; }
 
     static QString userEventTypeToString(UserEventType type);
 
-    void open(QHostAddress remoteAddr, quint16 port);
+    void setTransport(Transport *transport);
     void open();
     bool isConnected() { return _connected; }
     bool setCommunicationsGood(bool state);
@@ -115,13 +76,14 @@ public:
     bool setUserCode(uint32_t code);
     bool setProgrammerCode(uint32_t code);
 
-    // send command to IT-100 module
-    void sendCommand(QByteArray command, QByteArray data);
-    void sendCommand(QByteArray command, uint16_t data);
-    void sendCommand(QByteArray command);
+    // send command to IT-100 module; false if its lane would not take it
+    bool sendCommand(Command command, QByteArray data);
+    bool sendCommand(Command command, uint16_t data);
+    bool sendCommand(Command command);
+
+    // device or host:port, for log messages
+    QString linkName();
 
-    void setRemoteHostAddress(QHostAddress address);
-    void setRemoteHostPort(uint16_t port);
     void setPanelUserCode(uint32_t code) { panelUserCode = code; }
 
     int setZoneFriendlyName(int zoneNumber, QString name);
@@ -132,65 +94,162 @@ public:
     void disarm(int partition = 1);
     void setEnableVirtualKeypad(bool value = true);
 
-    bool isWaitingForStatusUpdate();
+    // press each key in turn with its keybreak; false if the sequence
+    // holds an invalid key or another sequence is still being sent
+    bool sendKeySequence(const QByteArray &keys);
+    bool isKeySequenceActive() { return !keySequence.isEmpty(); }
 
-    QHostAddress remoteHostAddress;
-    uint16_t remoteHostPort;
+    bool isWaitingForStatusUpdate();
+    void requestStatusSnapshot();
+
+    // receiver of every PanelEvent; not owned
+    void setEventConsumer(PanelEventConsumer *consumer) { eventConsumer = consumer; }
+
+    struct CommandLinkStats {
+        uint64_t sent = 0;          // transmissions, including retransmits
+        uint64_t acknowledged = 0;
+        uint64_t errors = 0;        // 501 command errors
+        uint64_t retransmits = 0;
+        uint64_t abandoned = 0;     // unanswered after commandMaxAttempts
+        uint64_t unmatchedAcks = 0;
+        int rttLastMsecs = 0;
+        int rttMinMsecs = 0;
+        int rttMaxMsecs = 0;
+        int rttAvgMsecs = 0;        // moving average
+    };
+
+    // commands allowed on the link awaiting acknowledgement, 1 - maxCommandWindow
+    void setCommandWindow(int size);
+    int getCommandWindow() { return commandWindow; }
+    const CommandLinkStats &commandLinkStats() const { return linkStats; }
+
+    // serial rate between the IT-100 and ser2net; writes are paced to it
+    void setLinkBaudRate(int baud) { pacer.setBaudRate(baud); }
+    const TransmitPacer::Stats &transmitPacerStats() const { return pacer.stats(); }
+    double linkUtilization() { return pacer.utilization(linkClock.elapsed()); }
+
+    // outbound queues, one per CommandLane
+    void setCommandOverflowPolicy(CommandQueue::OverflowPolicy policy);
+    const CommandQueue::Stats &commandQueueStats(CommandLane lane) const { return commandLanes[lane].stats(); }
+
+    // reconnect attempts and time-to-reconnect histogram
+    ConnectionSupervisor *supervisor() const { return linkSupervisor; }
+
+    // receive framing counters
+    const LineFramer::Stats &framerStats() const { return framer.stats(); }
+    uint64_t checksumRejectCount() const { return checksumRejects; }
+    uint64_t lengthRejectCount() const { return lengthRejects; }
 
     QString zoneFriendlyNames[64];
     QString lcdDisplayContents;
 
-    InterfaceType interfaceType;
-
     QDateTime lastTransmittedCommsAt; // When serial comms last sent to IT-100
     QDateTime lastReceivedCommsAt; // When serial comms last received
 
 private:
 
-    void writePacket();
-
-    // generate DSC style checksum from command+data bytes
-    QByteArray generateChecksum(QByteArray data);
+    struct InFlightCommand {
+        It100Message message;
+        int64_t sentAt;     // linkClock msecs of the last transmission
+        uint64_t sequence;  // order first taken from the lanes
+        int attempts;
+    };
 
-    // build packet from commmand+data bytes
-    QByteArray generatePacket(QByteArray command, QByteArray data);
-
-    int processReceivedLine(QByteArray data);
+    void processLinkUp();
+    void processLinkDown();
+    void writePacket();
+    bool transmit(InFlightCommand &command);
+    void removeInFlight(int index);
+    void retryInFlight(int index);
+    void armCommandDeadline();
+    void clearInFlight();
+
+    int processReceivedLine(const LineView &line);
+
+    // received command handlers, selected through the command table
+    typedef void (IT100::*CommandHandlerFn)(const CommandInfo &info,
+                                            const LineView &payload);
+    static const CommandHandlerFn commandHandlers[HANDLER_COUNT];
+
+    void handleAcknowledge(const CommandInfo &info, const LineView &payload);
+    void handleCommandError(const CommandInfo &info, const LineView &payload);
+    void handleZoneStatus(const CommandInfo &info, const LineView &payload);
+    void handlePartitionStatus(const CommandInfo &info, const LineView &payload);
+    void handlePartitionArmed(const CommandInfo &info, const LineView &payload);
+    void handleUserClosing(const CommandInfo &info, const LineView &payload);
+    void handleSpecialClosing(const CommandInfo &info, const LineView &payload);
+    void handlePartialClosing(const CommandInfo &info, const LineView &payload);
+    void handleUserOpening(const CommandInfo &info, const LineView &payload);
+    void handleInvalidAccessCode(const CommandInfo &info, const LineView &payload);
+    void handleLcdUpdate(const CommandInfo &info, const LineView &payload);
+    void handleTrouble(const CommandInfo &info, const LineView &payload);
+
+    void endStatusSnapshot(bool complete);
+    void endKeySequence(bool complete);
+    void onKeyAcknowledged();
+
+    PanelEvent newEvent(const CommandInfo &info, PanelEvent::Type type);
+    void dispatchEvent(const PanelEvent &event);
+
+    PanelEventConsumer *eventConsumer = nullptr;
+    int64_t lineReceivedAt = 0;
 
     ComponentStatus status = COMP_STATUS_UNKNOWN;
 
-    QTcpSocket *socket = nullptr;
+    Transport *transport = nullptr;
+    ConnectionSupervisor *linkSupervisor = nullptr;
     bool _connected;
-    bool _connectionIntent;
-    int _connectionAttempts;
     bool communicationsGood;
-    bool waitingForResponse;
     bool _waitingForStatusUpdate;
     bool _debugMode;
 
-    QList<It100Message*> messageQueueOut;
+    CommandQueue commandLanes[LANE_COUNT];
+
+    InFlightCommand inFlight[maxCommandWindow]; // oldest first
+    int inFlightCount = 0;
+    int commandWindow = 1;
+    uint64_t commandSequence = 0;
+    QElapsedTimer linkClock;
+    TransmitPacer pacer;
+    CommandLinkStats linkStats;
 
     // QTimers
     QTimer *pollTimer = nullptr;
     QTimer *timedisciplineTimer = nullptr;
     QTimer *communicationsTimeoutTimer = nullptr;
-    QTimer *moduleReconnectTimer = nullptr;
-
-    QString receivedData;
+    QTimer *snapshotTimeoutTimer = nullptr;
+    QTimer *commandDeadlineTimer = nullptr;
+    QTimer *keySequenceTimer = nullptr;
+    QTimer *transmitPacingTimer = nullptr;
+
+    QByteArray keySequence;
+    int keySequencePos = 0;
+    int keySequenceKeys = 0;
+    bool keyDown = false;
+    bool keyAwaitingAck = false;    // a 070 of the sequence is queued or in flight
+    int keyStepMsecs = 0;           // hold or gap once it is acknowledged
+
+    QElapsedTimer snapshotElapsed;
+    bool snapshotAcknowledged = false;
+    uint64_t snapshotMarkerSequence = 0;    // first command that may mark the end
+
+    LineFramer framer;
+    uint64_t checksumRejects = 0;
+    uint64_t lengthRejects = 0;     // data bytes not as the command table has them
 
     uint32_t panelUserCode;
     uint32_t panelProgrammerCode;
 
 private slots:
 
-    void processTcpSocketReadyRead();
+    void processReadyRead();
     void onPollTimerTimeout();
     void processTcpSocketConnected();
     void onTimeDisciplineTimerTimeout();
     void onCommunicationsTimeoutTimerTimeout();
-    void processModuleReconnectTimerTimeout();
-    void processTcpSocketStateChange(QAbstractSocket::SocketState);
-    void processTcpConnectRetryTimeout();
+    void onSnapshotTimeoutTimerTimeout();
+    void onCommandDeadlineTimerTimeout();
+    void onKeySequenceTimerTimeout();
 
 signals:
 
@@ -223,40 +282,12 @@ signals:
       */
     void communicationsTimeout();
 
-    /** user -1 when unknown */
-    void userEvent(UserEventType type, int partition, int user);
-
-    void zoneOpen(int partition, int zone);
-    void zoneRestored(int partition, int zone);
-    void zoneStatusChanged(int zone, int partition, ZoneStatus status);
-    void partitionStatusChanged(int partition, PartitionStatus status, int zone = 0);
-    void partitionArmedDescriptive(int partition, PartitionArmedMode mode);
-    void troubleEvent(TroubleEvent event);
-
-    /** an access code that was entered is invalid */
-    void invalidAccessCode(int partition);
-
-    /** indicates a partition has been armed by a user
-        note: this is sent after exit_delay */
-    void userClosing(int partition, int userCode);
-    
-    /** indicates partition has been armed by one of the following methods:
-        Quick Arm, Auto Arm, Keysiwtch, DLS Software, or Wireless Key */
-    void specialClosing(int partition);
-
-    /** indicates partition has been armed but one or more zones have 
-        been bypassed */
-    void partialClosing(int partition);
-
-    /** indicates partition has been opened by a user */
-    void userOpening(int partition, int userCode);
-
-    /** indicates partition has been disarmed by one of following methods:
-        Keyswitch, DLS Software, Wireless Key */
-    void specialOpening(int partition);
-
-
-    void virtualKeypadDisplayUpdate();
+    /**
+      * Signal called when a key sequence has been sent, or abandoned
+      * on disconnect
+      * \param keys number of keys pressed
+      */
+    void keySequenceComplete(int keys, bool complete);
 
 };
 
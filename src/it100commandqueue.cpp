@@ -0,0 +1,62 @@
+#include "it100commandqueue.h"
+
+namespace it100 {
+
+static_assert((CommandQueue::capacity & (CommandQueue::capacity - 1)) == 0,
+              "CommandQueue capacity must be a power of 2");
+
+bool CommandQueue::push(const It100Message &message, int64_t now)
+{
+    if (!message.isValid()) {
+        _stats.invalid++;
+        return false;
+    }
+
+    if (isFull()) {
+        _stats.dropped++;
+        if (_policy == RejectNewest) return false;
+        _head++;
+    }
+
+    _ring[_tail & mask] = message;
+    _queuedAt[_tail & mask] = now;
+    _tail++;
+
+    _stats.enqueued++;
+    if (depth() > _stats.depthHighWater) _stats.depthHighWater = depth();
+    return true;
+}
+
+/**
+  * pushCoalesced(message, now)
+  * Housekeeping such as polls and time sets only needs its latest
+  * copy sent; the queued one keeps its place and age
+  */
+bool CommandQueue::pushCoalesced(const It100Message &message, int64_t now)
+{
+    if (message.isValid()) {
+        for (uint32_t pos = _head; pos != _tail; pos++) {
+            if (_ring[pos & mask].command() == message.command()) {
+                _ring[pos & mask] = message;
+                _stats.coalesced++;
+                return true;
+            }
+        }
+    }
+    return push(message, now);
+}
+
+It100Message CommandQueue::take(int64_t now)
+{
+    uint32_t slot = _head & mask;
+    _head++;
+
+    int delay = static_cast<int>(now - _queuedAt[slot]);
+    _stats.delayLastMsecs = delay;
+    if (delay > _stats.delayMaxMsecs) _stats.delayMaxMsecs = delay;
+    _stats.delayAvgMsecs += (delay - _stats.delayAvgMsecs) / 8;
+
+    return _ring[slot];
+}
+
+} // namespace it100
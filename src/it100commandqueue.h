@@ -0,0 +1,123 @@
+#ifndef IT100COMMANDQUEUE_H
+#define IT100COMMANDQUEUE_H
+
+#include <cstdint>
+
+#include "it100message.h"
+
+namespace it100 {
+
+/**
+  * Outbound lanes, highest priority first
+  * A command is only sent when every lane above it is empty
+  */
+enum CommandLane : uint8_t {
+    LANE_LIFE_SAFETY,
+    LANE_ARM_DISARM,
+    LANE_INTERACTIVE,   // keypad and command outputs
+    LANE_HOUSEKEEPING,  // polls, status, time; coalesced
+    LANE_COUNT
+};
+
+constexpr CommandLane commandLane(Command command)
+{
+    switch (command) {
+    case CMD_TRIGGER_PANIC_ALARM:
+        return LANE_LIFE_SAFETY;
+    case CMD_PARTITION_ARM_CONTROL_AWAY:
+    case CMD_PARTITION_ARM_CONTROL_STAY:
+    case CMD_PARTITION_ARM_CONTROL_ARMED_NO_ENTRY_DELAY:
+    case CMD_PARTITION_ARM_CONTROL_WITH_CODE:
+    case CMD_PARTITION_DISARM_CONTROL_WITH_CODE:
+    case CMD_CODE_SEND:
+        return LANE_ARM_DISARM;
+    case CMD_KEY_PRESSED_VIRT:
+    case CMD_VIRTUAL_KEYPAD_CONTROL:
+    case CMD_COMMAND_OUTPUT_CONTROL:
+        return LANE_INTERACTIVE;
+    default:
+        return LANE_HOUSEKEEPING;
+    }
+}
+
+// for log messages
+constexpr const char *commandLaneName(CommandLane lane)
+{
+    switch (lane) {
+    case LANE_LIFE_SAFETY: return "life_safety";
+    case LANE_ARM_DISARM: return "arm_disarm";
+    case LANE_INTERACTIVE: return "interactive";
+    default: return "housekeeping";
+    }
+}
+
+/**
+  * CommandQueue
+  * Outbound commands waiting for the link, held by value in a fixed
+  * ring allocated with the queue
+  */
+class CommandQueue
+{
+public:
+
+    static const int capacity = 32; // must be a power of 2
+
+    // what push() does when the ring is full
+    enum OverflowPolicy {
+        RejectNewest,   // refuse the command being queued
+        DropOldest      // discard the command that has waited longest
+    };
+
+    struct Stats {
+        uint64_t enqueued = 0;
+        uint64_t dropped = 0;   // refused or discarded on overflow
+        uint64_t invalid = 0;   // data too long to send
+        uint64_t coalesced = 0; // replaced a queued command of the same code
+        int depthHighWater = 0;
+        int delayLastMsecs = 0; // time spent queued
+        int delayMaxMsecs = 0;
+        int delayAvgMsecs = 0;  // moving average
+    };
+
+    void setOverflowPolicy(OverflowPolicy policy) { _policy = policy; }
+    OverflowPolicy overflowPolicy() const { return _policy; }
+
+    // false if the message was not queued; now is a monotonic msec
+    // clock used to measure queueing delay
+    bool push(const It100Message &message, int64_t now);
+
+    // replace a queued message with the same command in place, else push
+    bool pushCoalesced(const It100Message &message, int64_t now);
+
+    // oldest message; the queue must not be empty
+    const It100Message &front() const { return _ring[_head & mask]; }
+
+    // remove the oldest message; the queue must not be empty
+    It100Message take(int64_t now);
+
+    bool isEmpty() const { return _head == _tail; }
+    bool isFull() const { return _tail - _head == static_cast<uint32_t>(capacity); }
+    int depth() const { return static_cast<int>(_tail - _head); }
+
+    void clear() { _head = _tail = 0; }
+
+    const Stats &stats() const { return _stats; }
+
+private:
+
+    static const uint32_t mask = capacity - 1;
+
+    It100Message _ring[capacity];
+    int64_t _queuedAt[capacity];
+
+    // free running positions; slot is pos & mask
+    uint32_t _head = 0;
+    uint32_t _tail = 0;
+
+    OverflowPolicy _policy = RejectNewest;
+    Stats _stats;
+};
+
+} // namespace it100
+
+#endif // IT100COMMANDQUEUE_H
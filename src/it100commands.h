@@ -1,121 +1,441 @@
-#ifndef IT100COMMANDS_H
-#define IT100COMMANDS_H
-
-#include <QByteArray>
-
-namespace it100 {
-
-/**
-  * Application Originated Commands
-  */
-inline const QByteArray CMD_POLL = "000";
-inline const QByteArray CMD_STATUS_REQUEST = "001";
-inline const QByteArray CMD_LABELS_REQUEST = "002";
-inline const QByteArray CMD_SET_TIME_AND_DATE = "010";
-inline const QByteArray CMD_COMMAND_OUTPUT_CONTROL = "020";
-inline const QByteArray CMD_PARTITION_ARM_CONTROL_AWAY = "030";
-inline const QByteArray CMD_PARTITION_ARM_CONTROL_STAY = "031";
-inline const QByteArray CMD_PARTITION_ARM_CONTROL_ARMED_NO_ENTRY_DELAY = "032";
-inline const QByteArray CMD_PARTITION_ARM_CONTROL_WITH_CODE = "033";
-inline const QByteArray CMD_PARTITION_DISARM_CONTROL_WITH_CODE = "040";
-inline const QByteArray CMD_TIME_STAMP_CONTROL = "055";
-inline const QByteArray CMD_TIME_DATE_BROADCAST_CONTROL = "056";
-inline const QByteArray CMD_TEMPERATURE_BROADCAST_CONTROL = "057";
-inline const QByteArray CMD_VIRTUAL_KEYPAD_CONTROL = "058";
-inline const QByteArray CMD_TRIGGER_PANIC_ALARM = "060";
-inline const QByteArray CMD_KEY_PRESSED_VIRT = "070";
-inline const QByteArray CMD_BAUD_RATE_CHANGE = "080";
-inline const QByteArray CMD_GET_TEMPERATURE_SET_POINT = "095";
-inline const QByteArray CMD_TEMPERATURE_CHANGE = "096";
-inline const QByteArray CMD_SAVE_TEMPERATURE_SETTING = "097";
-inline const QByteArray CMD_CODE_SEND = "200";
-
-/**
-  * IT-100 Originated Commands
-  */
-inline const QByteArray CMD_COMMAND_ACKNOWLEDGE = "500";
-inline const QByteArray CMD_COMMAND_ERROR = "501";
-inline const QByteArray CMD_SYSTEM_ERROR = "502";
-inline const QByteArray CMD_TIME_DATE_BROADCAST = "550";
-inline const QByteArray CMD_RING_DETECETD = "560";
-inline const QByteArray CMD_INDOOR_TEMPERATURE_BROADCAST = "561";
-inline const QByteArray CMD_OUTDOOR_TEMPERATURE_BROADCAST = "562";
-inline const QByteArray CMD_THERMOSTAT_SET_POINTS = "563";
-inline const QByteArray CMD_BROADCAST_LABELS = "570";
-inline const QByteArray CMD_BAUD_RATE_SET = "580";
-inline const QByteArray CMD_ZONE_ALARM = "601";
-inline const QByteArray CMD_ZONE_ALARM_RESTORE = "602";
-inline const QByteArray CMD_ZONE_TAMPER = "603";
-inline const QByteArray CMD_ZONE_TAMPER_RESTORE = "604";
-inline const QByteArray CMD_ZONE_FAULT = "605";
-inline const QByteArray CMD_ZONE_FAULT_RESTORE = "606";
-inline const QByteArray CMD_ZONE_OPEN = "609";
-inline const QByteArray CMD_ZONE_RESTORED = "610";
-inline const QByteArray CMD_DURESS_ALARM = "620";
-inline const QByteArray CMD_F_KEY_ALARM = "621";
-inline const QByteArray CMD_F_KEY_RESTORAL = "622";
-inline const QByteArray CMD_A_KEY_ALARM = "623";
-inline const QByteArray CMD_A_KEY_RESTORAL = "624";
-inline const QByteArray CMD_P_KEY_ALARM = "625";
-inline const QByteArray CMD_P_KEY_RESTORAL = "626";
-inline const QByteArray CMD_AUXILIARY_INPUT_ALARM = "631";
-inline const QByteArray CMD_AUXILIARY_INPUT_ALARM_RESTORED = "632";
-inline const QByteArray CMD_PARTITION_READY = "626";
-inline const QByteArray CMD_PARTITION_NOT_READY = "625";
-inline const QByteArray CMD_PARTITION_ARMED_DESCRIPTIVE_MODE = "652";
-inline const QByteArray CMD_PARTITION_IN_READY_TO_FORCE_ALARM = "653";
-inline const QByteArray CMD_PARTITION_IN_ALARM = "654";
-inline const QByteArray CMD_PARTITION_DISARMED = "655";
-inline const QByteArray CMD_EXIT_DELAY_IN_PROGRESS = "656";
-inline const QByteArray CMD_ENTRY_DELAY_IN_PROGRESS = "657";
-inline const QByteArray CMD_KEYPAD_LOCKOUT = "658";
-inline const QByteArray CMD_KEYPAD_BLANKING = "659";
-inline const QByteArray CMD_COMMAND_OUTPUT_IN_PROGRESS = "660";
-inline const QByteArray CMD_INVALID_ACCESS_CODE = "670";
-inline const QByteArray CMD_FUNCTION_NOT_AVAILABLE = "671";
-inline const QByteArray CMD_FAIL_TO_ARM = "672";
-inline const QByteArray CMD_PARTITION_BUSY = "673";
-inline const QByteArray CMD_USER_CLOSING = "700";
-inline const QByteArray CMD_SPECIAL_CLOSING = "701";
-inline const QByteArray CMD_PARTIAL_CLOSING = "702";
-inline const QByteArray CMD_USER_OPENING = "750";
-inline const QByteArray CMD_SPECIAL_OPENING = "751";
-inline const QByteArray CMD_PANEL_BATTERY_TROUBLE = "800";
-inline const QByteArray CMD_PANEL_BATTERY_TROUBLE_RESTORE ="801";
-inline const QByteArray CMD_PANEL_AC_TROUBLE = "802";
-inline const QByteArray CMD_PANEL_AC_RESTORE = "803";
-inline const QByteArray CMD_SYSTEM_BELL_TROUBLE ="806";
-inline const QByteArray CMD_SYSTEM_BELL_TROUBLE_RESTORAL = "807";
-inline const QByteArray CMD_TLM_LINE_1_TROUBLE = "810";
-inline const QByteArray CMD_TLM_LINE_1_TROUBLE_RESTORAL = "811";
-inline const QByteArray CMD_TLM_LINE_2_TROUBLE = "812";
-inline const QByteArray CMD_TLM_LINE_2_TROUBLE_RESTORAL = "813";
-inline const QByteArray CMD_FTC_TROUBLE = "814";
-inline const QByteArray CMD_BUFFER_NEAR_FULL = "816";
-inline const QByteArray CMD_GENERAL_DEVICE_LOW_BATTERY = "821";
-inline const QByteArray CMD_GENERAL_DEVICE_LOW_BATTERY_RESTORE = "822";
-inline const QByteArray CMD_WIRELESS_KEY_LOW_BATTERY_TROUBLE = "825";
-inline const QByteArray CMD_WIRELESS_KEY_LOW_BATTERY_TROUBLE_RESTORE = "826";
-inline const QByteArray CMD_HANDHELD_KEYPAD_LOW_BATTERY_TROUBLE = "827";
-inline const QByteArray CMD_HANDHELD_KEYPAD_LOW_BATTERY_TROUBLE_RESTORE = "828";
-inline const QByteArray CMD_GENERAL_SYSTEM_TAMPER = "829";
-inline const QByteArray CMD_GENERAL_SYSTEM_TAMPER_RESTORE = "830";
-inline const QByteArray CMD_HOME_AUTOMATION_TROUBLE = "831";
-inline const QByteArray CMD_HOME_AUTOMATION_TROUBLE_RESTORE = "832";
-inline const QByteArray CMD_TROUBLE_STATUS_LED_ON = "840";
-inline const QByteArray CMD_TROUBLE_STATUS_LED_OFF = "841";
-inline const QByteArray CMD_FIRE_TROUBLE_ALARM = "842";
-inline const QByteArray CMD_FIRE_TROUBLE_ALARM_RESTORE = "843";
-inline const QByteArray CMD_CODE_REQUIRED = "900";
-inline const QByteArray CMD_LCD_UPDATE = "901";
-inline const QByteArray CMD_LCD_CURSOR = "902";
-inline const QByteArray CMD_LED_STATUS = "903";
-inline const QByteArray CMD_BEEP_STATUS = "904";
-inline const QByteArray CMD_TONE_STATUS = "905";
-inline const QByteArray CMD_BUZZER_STATUS = "906";
-inline const QByteArray CMD_DOOR_CHIME_STATUS = "907";
-inline const QByteArray CMD_SOFTWARE_VERSION = "908";
-
-} // namespace it100
-
-#endif // IT100COMMANDS_H
+#ifndef IT100COMMANDS_H
+#define IT100COMMANDS_H
+
+#include <array>
+#include <cstdint>
+
+namespace it100 {
+
+/**
+  * DSC IT-100 command codes
+  * The enum value is the 3-digit code sent on the wire
+  */
+enum Command : uint16_t {
+
+    /**
+      * Application Originated Commands
+      */
+    CMD_POLL = 0,
+    CMD_STATUS_REQUEST = 1,
+    CMD_LABELS_REQUEST = 2,
+    CMD_SET_TIME_AND_DATE = 10,
+    CMD_COMMAND_OUTPUT_CONTROL = 20,
+    CMD_PARTITION_ARM_CONTROL_AWAY = 30,
+    CMD_PARTITION_ARM_CONTROL_STAY = 31,
+    CMD_PARTITION_ARM_CONTROL_ARMED_NO_ENTRY_DELAY = 32,
+    CMD_PARTITION_ARM_CONTROL_WITH_CODE = 33,
+    CMD_PARTITION_DISARM_CONTROL_WITH_CODE = 40,
+    CMD_TIME_STAMP_CONTROL = 55,
+    CMD_TIME_DATE_BROADCAST_CONTROL = 56,
+    CMD_TEMPERATURE_BROADCAST_CONTROL = 57,
+    CMD_VIRTUAL_KEYPAD_CONTROL = 58,
+    CMD_TRIGGER_PANIC_ALARM = 60,
+    CMD_KEY_PRESSED_VIRT = 70,
+    CMD_BAUD_RATE_CHANGE = 80,
+    CMD_GET_TEMPERATURE_SET_POINT = 95,
+    CMD_TEMPERATURE_CHANGE = 96,
+    CMD_SAVE_TEMPERATURE_SETTING = 97,
+    CMD_CODE_SEND = 200,
+
+    /**
+      * IT-100 Originated Commands
+      */
+    CMD_COMMAND_ACKNOWLEDGE = 500,
+    CMD_COMMAND_ERROR = 501,
+    CMD_SYSTEM_ERROR = 502,
+    CMD_TIME_DATE_BROADCAST = 550,
+    CMD_RING_DETECETD = 560,
+    CMD_INDOOR_TEMPERATURE_BROADCAST = 561,
+    CMD_OUTDOOR_TEMPERATURE_BROADCAST = 562,
+    CMD_THERMOSTAT_SET_POINTS = 563,
+    CMD_BROADCAST_LABELS = 570,
+    CMD_BAUD_RATE_SET = 580,
+    CMD_ZONE_ALARM = 601,
+    CMD_ZONE_ALARM_RESTORE = 602,
+    CMD_ZONE_TAMPER = 603,
+    CMD_ZONE_TAMPER_RESTORE = 604,
+    CMD_ZONE_FAULT = 605,
+    CMD_ZONE_FAULT_RESTORE = 606,
+    CMD_ZONE_OPEN = 609,
+    CMD_ZONE_RESTORED = 610,
+    CMD_DURESS_ALARM = 620,
+    CMD_F_KEY_ALARM = 621,
+    CMD_F_KEY_RESTORAL = 622,
+    CMD_A_KEY_ALARM = 623,
+    CMD_A_KEY_RESTORAL = 624,
+    CMD_P_KEY_ALARM = 625,
+    CMD_P_KEY_RESTORAL = 626,
+    CMD_AUXILIARY_INPUT_ALARM = 631,
+    CMD_AUXILIARY_INPUT_ALARM_RESTORED = 632,
+    CMD_PARTITION_READY = 650,
+    CMD_PARTITION_NOT_READY = 651,
+    CMD_PARTITION_ARMED_DESCRIPTIVE_MODE = 652,
+    CMD_PARTITION_IN_READY_TO_FORCE_ALARM = 653,
+    CMD_PARTITION_IN_ALARM = 654,
+    CMD_PARTITION_DISARMED = 655,
+    CMD_EXIT_DELAY_IN_PROGRESS = 656,
+    CMD_ENTRY_DELAY_IN_PROGRESS = 657,
+    CMD_KEYPAD_LOCKOUT = 658,
+    CMD_KEYPAD_BLANKING = 659,
+    CMD_COMMAND_OUTPUT_IN_PROGRESS = 660,
+    CMD_INVALID_ACCESS_CODE = 670,
+    CMD_FUNCTION_NOT_AVAILABLE = 671,
+    CMD_FAIL_TO_ARM = 672,
+    CMD_PARTITION_BUSY = 673,
+    CMD_USER_CLOSING = 700,
+    CMD_SPECIAL_CLOSING = 701,
+    CMD_PARTIAL_CLOSING = 702,
+    CMD_USER_OPENING = 750,
+    CMD_SPECIAL_OPENING = 751,
+    CMD_PANEL_BATTERY_TROUBLE = 800,
+    CMD_PANEL_BATTERY_TROUBLE_RESTORE = 801,
+    CMD_PANEL_AC_TROUBLE = 802,
+    CMD_PANEL_AC_RESTORE = 803,
+    CMD_SYSTEM_BELL_TROUBLE = 806,
+    CMD_SYSTEM_BELL_TROUBLE_RESTORAL = 807,
+    CMD_TLM_LINE_1_TROUBLE = 810,
+    CMD_TLM_LINE_1_TROUBLE_RESTORAL = 811,
+    CMD_TLM_LINE_2_TROUBLE = 812,
+    CMD_TLM_LINE_2_TROUBLE_RESTORAL = 813,
+    CMD_FTC_TROUBLE = 814,
+    CMD_BUFFER_NEAR_FULL = 816,
+    CMD_GENERAL_DEVICE_LOW_BATTERY = 821,
+    CMD_GENERAL_DEVICE_LOW_BATTERY_RESTORE = 822,
+    CMD_WIRELESS_KEY_LOW_BATTERY_TROUBLE = 825,
+    CMD_WIRELESS_KEY_LOW_BATTERY_TROUBLE_RESTORE = 826,
+    CMD_HANDHELD_KEYPAD_LOW_BATTERY_TROUBLE = 827,
+    CMD_HANDHELD_KEYPAD_LOW_BATTERY_TROUBLE_RESTORE = 828,
+    CMD_GENERAL_SYSTEM_TAMPER = 829,
+    CMD_GENERAL_SYSTEM_TAMPER_RESTORE = 830,
+    CMD_HOME_AUTOMATION_TROUBLE = 831,
+    CMD_HOME_AUTOMATION_TROUBLE_RESTORE = 832,
+    CMD_TROUBLE_STATUS_LED_ON = 840,
+    CMD_TROUBLE_STATUS_LED_OFF = 841,
+    CMD_FIRE_TROUBLE_ALARM = 842,
+    CMD_FIRE_TROUBLE_ALARM_RESTORE = 843,
+    CMD_CODE_REQUIRED = 900,
+    CMD_LCD_UPDATE = 901,
+    CMD_LCD_CURSOR = 902,
+    CMD_LED_STATUS = 903,
+    CMD_BEEP_STATUS = 904,
+    CMD_TONE_STATUS = 905,
+    CMD_BUZZER_STATUS = 906,
+    CMD_DOOR_CHIME_STATUS = 907,
+    CMD_SOFTWARE_VERSION = 908,
+
+    // not a valid code; used for the unknown entry of the command table
+    CMD_INVALID = 1000
+};
+
+enum ZoneStatus {
+    ZONE_STATUS_OPEN,
+    ZONE_STATUS_RESTORED,
+    ZONE_STATUS_TAMPER,
+    ZONE_STATUS_TAMPER_RESTORED,
+    ZONE_STATUS_FAULT,
+    ZONE_STATUS_FAULT_RESTORED,
+    ZONE_STATUS_ALARM,
+    ZONE_STATUS_ALARM_RESTORED
+};
+
+enum PartitionStatus {
+    PARTITION_STATUS_ARMED,
+    PARTITION_STATUS_DISARMED,
+    PARTITION_STATUS_ALARM,
+    PARTITION_STATUS_RESTORE,
+    PARTITION_STATUS_READY,
+    PARTITION_STATUS_NOT_READY,
+    PARTITION_STATUS_READY_FORCE_ARM,
+    PARTITION_STATUS_EXIT_DELAY_IN_PROGRESS,
+    PARTITION_STATUS_ENTRY_DELAY_IN_PROGRESS,
+    PARTITION_STATUS_USER_CLOSING,
+    PARTITION_STATUS_PARTIAL_CLOSING,
+    PARTITION_STATUS_SPECIAL_CLOSING,
+    PARTITION_STATUS_INVALID_ACCESS_CODE,
+    PARTITION_STATUS_FUNCTION_NOT_AVAILABLE,
+    PARTITION_STATUS_BUSY
+};
+
+enum PartitionArmedMode {
+    PARTITION_ARMED_AWAY = 0,
+    PARTITION_ARMED_STAY = 1,
+    PARTITION_ARMED_AWAY_NODELAY = 2,
+    PARTITION_ARMED_STAY_NODELAY = 3
+};
+
+enum TroubleEvent {
+    TROUBLE_PANEL_BATTERY,
+    TROUBLE_PANEL_BATTERY_RESTORE,
+    TROUBLE_PANEL_AC,
+    TROUBLE_PANEL_AC_RESTORE,
+    TROUBLE_SYSTEM_BELL,
+    TROUBLE_SYSTEM_BELL_RESTORE,
+    TROUBLE_TLM_1,
+    TROUBLE_TLM_1_RESTORE,
+    TROUBLE_TLM_2,
+    TROUBLE_TLM_2_RESTORE,
+    TROUBLE_FTC,
+    TROUBLE_BUFFER_NEAR_FULL,
+    TROUBLE_GENERAL_DEVICE_LOW_BATTERY,
+    TROUBLE_GENERAL_DEVICE_LOW_BATTERY_RESTORE,
+    TROUBLE_GENERAL_SYSTEM_TAMPER,
+    TROUBLE_GENERAL_SYSTEM_TAMPER_RESTORE,
+    TROUBLE_WIRELESS_KEY_LOW_BATTERY,
+    TROUBLE_WIRELESS_KEY_LOW_BATTERY_RESTORE,
+    TROUBLE_HANDHELD_KEYPAD_LOW_BATTERY,
+    TROUBLE_HANDHELD_KEYPAD_LOW_BATTERY_RESTORE,
+    TROUBLE_HOME_AUTOMATION,
+    TROUBLE_HOME_AUTOMATION_RESTORE
+};
+
+/**
+  * Handler selected for a received command
+  * IT100::commandHandlers is ordered the same way
+  */
+enum CommandHandler : uint8_t {
+    HANDLER_NONE = 0,
+    HANDLER_ACKNOWLEDGE,
+    HANDLER_COMMAND_ERROR,
+    HANDLER_ZONE_STATUS,        // arg is ZoneStatus
+    HANDLER_PARTITION_STATUS,   // arg is PartitionStatus
+    HANDLER_PARTITION_ARMED,
+    HANDLER_USER_CLOSING,
+    HANDLER_SPECIAL_CLOSING,
+    HANDLER_PARTIAL_CLOSING,
+    HANDLER_USER_OPENING,
+    HANDLER_INVALID_ACCESS_CODE,
+    HANDLER_LCD_UPDATE,
+    HANDLER_TROUBLE,            // arg is TroubleEvent
+    HANDLER_COUNT
+};
+
+// payload length of commands which do not have a fixed number of data bytes
+inline constexpr int8_t PAYLOAD_VARIABLE = -1;
+
+struct CommandInfo {
+    Command code;
+    const char *name;
+    int8_t payloadLength;
+    CommandHandler handler;
+    uint8_t arg;
+};
+
+/**
+  * Command Table
+  * One entry per known code; entry 0 is returned for unknown codes
+  */
+inline constexpr CommandInfo commandTable[] = {
+    { CMD_INVALID, "unknown", PAYLOAD_VARIABLE, HANDLER_NONE, 0 },
+
+    // Application Originated Commands
+    { CMD_POLL, "poll", 0, HANDLER_NONE, 0 },
+    { CMD_STATUS_REQUEST, "status_request", 0, HANDLER_NONE, 0 },
+    { CMD_LABELS_REQUEST, "labels_request", 0, HANDLER_NONE, 0 },
+    { CMD_SET_TIME_AND_DATE, "set_time_and_date", 10, HANDLER_NONE, 0 },
+    { CMD_COMMAND_OUTPUT_CONTROL, "command_output_control", 2, HANDLER_NONE, 0 },
+    { CMD_PARTITION_ARM_CONTROL_AWAY, "partition_arm_away", 1, HANDLER_NONE, 0 },
+    { CMD_PARTITION_ARM_CONTROL_STAY, "partition_arm_stay", 1, HANDLER_NONE, 0 },
+    { CMD_PARTITION_ARM_CONTROL_ARMED_NO_ENTRY_DELAY, "partition_arm_no_entry_delay", 1, HANDLER_NONE, 0 },
+    { CMD_PARTITION_ARM_CONTROL_WITH_CODE, "partition_arm_with_code", 7, HANDLER_NONE, 0 },
+    { CMD_PARTITION_DISARM_CONTROL_WITH_CODE, "partition_disarm_with_code", 7, HANDLER_NONE, 0 },
+    { CMD_TIME_STAMP_CONTROL, "time_stamp_control", 1, HANDLER_NONE, 0 },
+    { CMD_TIME_DATE_BROADCAST_CONTROL, "time_date_broadcast_control", 1, HANDLER_NONE, 0 },
+    { CMD_TEMPERATURE_BROADCAST_CONTROL, "temperature_broadcast_control", 1, HANDLER_NONE, 0 },
+    { CMD_VIRTUAL_KEYPAD_CONTROL, "virtual_keypad_control", 1, HANDLER_NONE, 0 },
+    { CMD_TRIGGER_PANIC_ALARM, "trigger_panic_alarm", 1, HANDLER_NONE, 0 },
+    { CMD_KEY_PRESSED_VIRT, "key_pressed", 1, HANDLER_NONE, 0 },
+    { CMD_BAUD_RATE_CHANGE, "baud_rate_change", 1, HANDLER_NONE, 0 },
+    { CMD_GET_TEMPERATURE_SET_POINT, "get_temperature_set_point", 1, HANDLER_NONE, 0 },
+    { CMD_TEMPERATURE_CHANGE, "temperature_change", PAYLOAD_VARIABLE, HANDLER_NONE, 0 },
+    { CMD_SAVE_TEMPERATURE_SETTING, "save_temperature_setting", 1, HANDLER_NONE, 0 },
+    { CMD_CODE_SEND, "code_send", 6, HANDLER_NONE, 0 },
+
+    // IT-100 Originated Commands
+    { CMD_COMMAND_ACKNOWLEDGE, "command_acknowledge", 3, HANDLER_ACKNOWLEDGE, 0 },
+    { CMD_COMMAND_ERROR, "command_error", PAYLOAD_VARIABLE, HANDLER_COMMAND_ERROR, 0 },
+    { CMD_SYSTEM_ERROR, "system_error", 3, HANDLER_NONE, 0 },
+    { CMD_TIME_DATE_BROADCAST, "time_date_broadcast", 10, HANDLER_NONE, 0 },
+    { CMD_RING_DETECETD, "ring_detected", 0, HANDLER_NONE, 0 },
+    { CMD_INDOOR_TEMPERATURE_BROADCAST, "indoor_temperature_broadcast", 4, HANDLER_NONE, 0 },
+    { CMD_OUTDOOR_TEMPERATURE_BROADCAST, "outdoor_temperature_broadcast", 4, HANDLER_NONE, 0 },
+    { CMD_THERMOSTAT_SET_POINTS, "thermostat_set_points", 7, HANDLER_NONE, 0 },
+    { CMD_BROADCAST_LABELS, "broadcast_labels", 35, HANDLER_NONE, 0 },
+    { CMD_BAUD_RATE_SET, "baud_rate_set", 1, HANDLER_NONE, 0 },
+    { CMD_ZONE_ALARM, "zone_alarm", 4, HANDLER_ZONE_STATUS, ZONE_STATUS_ALARM },
+    { CMD_ZONE_ALARM_RESTORE, "zone_alarm_restore", 4, HANDLER_ZONE_STATUS, ZONE_STATUS_ALARM_RESTORED },
+    { CMD_ZONE_TAMPER, "zone_tamper", 4, HANDLER_ZONE_STATUS, ZONE_STATUS_TAMPER },
+    { CMD_ZONE_TAMPER_RESTORE, "zone_tamper_restore", 4, HANDLER_ZONE_STATUS, ZONE_STATUS_TAMPER_RESTORED },
+    { CMD_ZONE_FAULT, "zone_fault", 3, HANDLER_ZONE_STATUS, ZONE_STATUS_FAULT },
+    { CMD_ZONE_FAULT_RESTORE, "zone_fault_restore", 3, HANDLER_ZONE_STATUS, ZONE_STATUS_FAULT_RESTORED },
+    { CMD_ZONE_OPEN, "zone_open", 3, HANDLER_ZONE_STATUS, ZONE_STATUS_OPEN },
+    { CMD_ZONE_RESTORED, "zone_restored", 3, HANDLER_ZONE_STATUS, ZONE_STATUS_RESTORED },
+    { CMD_DURESS_ALARM, "duress_alarm", 1, HANDLER_NONE, 0 },
+    { CMD_F_KEY_ALARM, "f_key_alarm", 0, HANDLER_NONE, 0 },
+    { CMD_F_KEY_RESTORAL, "f_key_restoral", 0, HANDLER_NONE, 0 },
+    { CMD_A_KEY_ALARM, "a_key_alarm", 0, HANDLER_NONE, 0 },
+    { CMD_A_KEY_RESTORAL, "a_key_restoral", 0, HANDLER_NONE, 0 },
+    { CMD_P_KEY_ALARM, "p_key_alarm", 0, HANDLER_NONE, 0 },
+    { CMD_P_KEY_RESTORAL, "p_key_restoral", 0, HANDLER_NONE, 0 },
+    { CMD_AUXILIARY_INPUT_ALARM, "auxiliary_input_alarm", 0, HANDLER_NONE, 0 },
+    { CMD_AUXILIARY_INPUT_ALARM_RESTORED, "auxiliary_input_alarm_restored", 0, HANDLER_NONE, 0 },
+    { CMD_PARTITION_READY, "partition_ready", 1, HANDLER_PARTITION_STATUS, PARTITION_STATUS_READY },
+    { CMD_PARTITION_NOT_READY, "partition_not_ready", 1, HANDLER_PARTITION_STATUS, PARTITION_STATUS_NOT_READY },
+    { CMD_PARTITION_ARMED_DESCRIPTIVE_MODE, "partition_armed", 2, HANDLER_PARTITION_ARMED, 0 },
+    { CMD_PARTITION_IN_READY_TO_FORCE_ALARM, "partition_ready_force_arm", 1, HANDLER_PARTITION_STATUS, PARTITION_STATUS_READY_FORCE_ARM },
+    { CMD_PARTITION_IN_ALARM, "partition_in_alarm", 1, HANDLER_PARTITION_STATUS, PARTITION_STATUS_ALARM },
+    { CMD_PARTITION_DISARMED, "partition_disarmed", 1, HANDLER_PARTITION_STATUS, PARTITION_STATUS_DISARMED },
+    { CMD_EXIT_DELAY_IN_PROGRESS, "exit_delay_in_progress", 1, HANDLER_PARTITION_STATUS, PARTITION_STATUS_EXIT_DELAY_IN_PROGRESS },
+    { CMD_ENTRY_DELAY_IN_PROGRESS, "entry_delay_in_progress", 1, HANDLER_PARTITION_STATUS, PARTITION_STATUS_ENTRY_DELAY_IN_PROGRESS },
+    { CMD_KEYPAD_LOCKOUT, "keypad_lockout", 1, HANDLER_NONE, 0 },
+    { CMD_KEYPAD_BLANKING, "keypad_blanking", 1, HANDLER_NONE, 0 },
+    { CMD_COMMAND_OUTPUT_IN_PROGRESS, "command_output_in_progress", 1, HANDLER_NONE, 0 },
+    { CMD_INVALID_ACCESS_CODE, "invalid_access_code", 1, HANDLER_INVALID_ACCESS_CODE, 0 },
+    { CMD_FUNCTION_NOT_AVAILABLE, "function_not_available", 1, HANDLER_PARTITION_STATUS, PARTITION_STATUS_FUNCTION_NOT_AVAILABLE },
+    { CMD_FAIL_TO_ARM, "fail_to_arm", 1, HANDLER_NONE, 0 },
+    { CMD_PARTITION_BUSY, "partition_busy", 1, HANDLER_PARTITION_STATUS, PARTITION_STATUS_BUSY },
+    { CMD_USER_CLOSING, "user_closing", 5, HANDLER_USER_CLOSING, 0 },
+    { CMD_SPECIAL_CLOSING, "special_closing", 1, HANDLER_SPECIAL_CLOSING, 0 },
+    { CMD_PARTIAL_CLOSING, "partial_closing", 1, HANDLER_PARTIAL_CLOSING, 0 },
+    { CMD_USER_OPENING, "user_opening", 5, HANDLER_USER_OPENING, 0 },
+    { CMD_SPECIAL_OPENING, "special_opening", 1, HANDLER_NONE, 0 },
+    { CMD_PANEL_BATTERY_TROUBLE, "panel_battery_trouble", 0, HANDLER_TROUBLE, TROUBLE_PANEL_BATTERY },
+    { CMD_PANEL_BATTERY_TROUBLE_RESTORE, "panel_battery_trouble_restore", 0, HANDLER_TROUBLE, TROUBLE_PANEL_BATTERY_RESTORE },
+    { CMD_PANEL_AC_TROUBLE, "panel_ac_trouble", 0, HANDLER_TROUBLE, TROUBLE_PANEL_AC },
+    { CMD_PANEL_AC_RESTORE, "panel_ac_restore", 0, HANDLER_TROUBLE, TROUBLE_PANEL_AC_RESTORE },
+    { CMD_SYSTEM_BELL_TROUBLE, "system_bell_trouble", 0, HANDLER_TROUBLE, TROUBLE_SYSTEM_BELL },
+    { CMD_SYSTEM_BELL_TROUBLE_RESTORAL, "system_bell_trouble_restoral", 0, HANDLER_TROUBLE, TROUBLE_SYSTEM_BELL_RESTORE },
+    { CMD_TLM_LINE_1_TROUBLE, "tlm_line_1_trouble", 0, HANDLER_TROUBLE, TROUBLE_TLM_1 },
+    { CMD_TLM_LINE_1_TROUBLE_RESTORAL, "tlm_line_1_trouble_restoral", 0, HANDLER_TROUBLE, TROUBLE_TLM_1_RESTORE },
+    { CMD_TLM_LINE_2_TROUBLE, "tlm_line_2_trouble", 0, HANDLER_TROUBLE, TROUBLE_TLM_2 },
+    { CMD_TLM_LINE_2_TROUBLE_RESTORAL, "tlm_line_2_trouble_restoral", 0, HANDLER_TROUBLE, TROUBLE_TLM_2_RESTORE },
+    { CMD_FTC_TROUBLE, "ftc_trouble", 0, HANDLER_TROUBLE, TROUBLE_FTC },
+    { CMD_BUFFER_NEAR_FULL, "buffer_near_full", 0, HANDLER_TROUBLE, TROUBLE_BUFFER_NEAR_FULL },
+    { CMD_GENERAL_DEVICE_LOW_BATTERY, "general_device_low_battery", 3, HANDLER_TROUBLE, TROUBLE_GENERAL_DEVICE_LOW_BATTERY },
+    { CMD_GENERAL_DEVICE_LOW_BATTERY_RESTORE, "general_device_low_battery_restore", 3, HANDLER_TROUBLE, TROUBLE_GENERAL_DEVICE_LOW_BATTERY_RESTORE },
+    { CMD_WIRELESS_KEY_LOW_BATTERY_TROUBLE, "wireless_key_low_battery_trouble", 3, HANDLER_TROUBLE, TROUBLE_WIRELESS_KEY_LOW_BATTERY },
+    { CMD_WIRELESS_KEY_LOW_BATTERY_TROUBLE_RESTORE, "wireless_key_low_battery_trouble_restore", 3, HANDLER_TROUBLE, TROUBLE_WIRELESS_KEY_LOW_BATTERY_RESTORE },
+    { CMD_HANDHELD_KEYPAD_LOW_BATTERY_TROUBLE, "handheld_keypad_low_battery_trouble", 1, HANDLER_TROUBLE, TROUBLE_HANDHELD_KEYPAD_LOW_BATTERY },
+    { CMD_HANDHELD_KEYPAD_LOW_BATTERY_TROUBLE_RESTORE, "handheld_keypad_low_battery_trouble_restore", 1, HANDLER_TROUBLE, TROUBLE_HANDHELD_KEYPAD_LOW_BATTERY_RESTORE },
+    { CMD_GENERAL_SYSTEM_TAMPER, "general_system_tamper", 0, HANDLER_TROUBLE, TROUBLE_GENERAL_SYSTEM_TAMPER },
+    { CMD_GENERAL_SYSTEM_TAMPER_RESTORE, "general_system_tamper_restore", 0, HANDLER_TROUBLE, TROUBLE_GENERAL_SYSTEM_TAMPER_RESTORE },
+    { CMD_HOME_AUTOMATION_TROUBLE, "home_automation_trouble", 0, HANDLER_TROUBLE, TROUBLE_HOME_AUTOMATION },
+    { CMD_HOME_AUTOMATION_TROUBLE_RESTORE, "home_automation_trouble_restore", 0, HANDLER_TROUBLE, TROUBLE_HOME_AUTOMATION_RESTORE },
+    { CMD_TROUBLE_STATUS_LED_ON, "trouble_status_led_on", 1, HANDLER_NONE, 0 },
+    { CMD_TROUBLE_STATUS_LED_OFF, "trouble_status_led_off", 1, HANDLER_NONE, 0 },
+    { CMD_FIRE_TROUBLE_ALARM, "fire_trouble_alarm", 0, HANDLER_NONE, 0 },
+    { CMD_FIRE_TROUBLE_ALARM_RESTORE, "fire_trouble_alarm_restore", 0, HANDLER_NONE, 0 },
+    { CMD_CODE_REQUIRED, "code_required", 2, HANDLER_NONE, 0 },
+    { CMD_LCD_UPDATE, "lcd_update", PAYLOAD_VARIABLE, HANDLER_LCD_UPDATE, 0 },
+    { CMD_LCD_CURSOR, "lcd_cursor", 4, HANDLER_NONE, 0 },
+    { CMD_LED_STATUS, "led_status", 2, HANDLER_NONE, 0 },
+    { CMD_BEEP_STATUS, "beep_status", PAYLOAD_VARIABLE, HANDLER_NONE, 0 },
+    { CMD_TONE_STATUS, "tone_status", PAYLOAD_VARIABLE, HANDLER_NONE, 0 },
+    { CMD_BUZZER_STATUS, "buzzer_status", PAYLOAD_VARIABLE, HANDLER_NONE, 0 },
+    { CMD_DOOR_CHIME_STATUS, "door_chime_status", 0, HANDLER_NONE, 0 },
+    { CMD_SOFTWARE_VERSION, "software_version", 4, HANDLER_NONE, 0 }
+};
+
+inline constexpr int commandTableSize =
+        static_cast<int>(sizeof(commandTable) / sizeof(commandTable[0]));
+
+static_assert(commandTableSize <= 256, "command index is stored as uint8_t");
+
+// Build flat 3-digit code -> commandTable index lookup; 0 is unknown
+constexpr std::array<uint8_t, 1000> buildCommandIndex()
+{
+    std::array<uint8_t, 1000> index {};
+    for (int i = 1; i < commandTableSize; i++)
+        index[commandTable[i].code] = static_cast<uint8_t>(i);
+    return index;
+}
+
+constexpr bool commandTableCodesUnique()
+{
+    for (int i = 1; i < commandTableSize; i++)
+        for (int j = i + 1; j < commandTableSize; j++)
+            if (commandTable[i].code == commandTable[j].code) return false;
+    return true;
+}
+
+static_assert(commandTableCodesUnique(), "duplicate code in command table");
+
+inline constexpr std::array<uint8_t, 1000> commandIndex = buildCommandIndex();
+
+/**
+  * commandInfo(code)
+  * Table entry for a 3-digit code; the unknown entry if not recognized
+  */
+constexpr const CommandInfo &commandInfo(int code)
+{
+    return commandTable[(code >= 0 && code < 1000) ? commandIndex[code] : 0];
+}
+
+/**
+  * parseCommandCode(data)
+  * Decode 3 ASCII digits; -1 if not numeric
+  */
+constexpr int parseCommandCode(const char *data)
+{
+    for (int i = 0; i < 3; i++)
+        if (data[i] < '0' || data[i] > '9') return -1;
+    return (data[0] - '0') * 100 + (data[1] - '0') * 10 + (data[2] - '0');
+}
+
+/**
+  * writeCommandCode(command, out)
+  * Encode command as the 3 ASCII digits sent on the wire
+  */
+inline void writeCommandCode(Command command, char *out)
+{
+    out[0] = static_cast<char>('0' + (command / 100) % 10);
+    out[1] = static_cast<char>('0' + (command / 10) % 10);
+    out[2] = static_cast<char>('0' + command % 10);
+}
+
+/**
+  * checksum(data, length)
+  * DSC checksum; low 8 bits of the sum of the command+data bytes
+  */
+constexpr uint8_t checksum(const char *data, int length)
+{
+    unsigned int sum = 0;
+    for (int i = 0; i < length; i++)
+        sum += static_cast<unsigned char>(data[i]);
+    return static_cast<uint8_t>(sum);
+}
+
+/**
+  * writeChecksum(sum, out)
+  * Encode checksum as the 2 upper case hex digits sent on the wire
+  */
+inline void writeChecksum(uint8_t sum, char *out)
+{
+    static const char hexDigits[] = "0123456789ABCDEF";
+    out[0] = hexDigits[sum >> 4];
+    out[1] = hexDigits[sum & 0x0F];
+}
+
+constexpr int hexDigitValue(char c)
+{
+    return (c >= '0' && c <= '9') ? c - '0' :
+           (c >= 'A' && c <= 'F') ? c - 'A' + 10 :
+           (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+}
+
+/**
+  * verifyChecksum(frame, length)
+  * Frame is command+data followed by the 2 checksum digits,
+  * without the CR/LF
+  */
+constexpr bool verifyChecksum(const char *frame, int length)
+{
+    if (length < 5) return false;
+    int high = hexDigitValue(frame[length - 2]);
+    int low = hexDigitValue(frame[length - 1]);
+    if (high < 0 || low < 0) return false;
+    return checksum(frame, length - 2) == ((high << 4) | low);
+}
+
+} // namespace it100
+
+#endif // IT100COMMANDS_H
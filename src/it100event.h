@@ -0,0 +1,56 @@
+#ifndef IT100EVENT_H
+#define IT100EVENT_H
+
+#include <cstdint>
+
+namespace it100 {
+
+/**
+  * PanelEvent
+  * One record per received panel line that reports a change
+  * Plain data so it can be copied, queued, logged or replayed
+  */
+struct PanelEvent {
+
+    enum Type : uint8_t {
+        Zone,               // status is ZoneStatus
+        Partition,          // status is PartitionStatus
+        PartitionArmed,     // status is PartitionArmedMode
+        User,               // status is UserEventType
+        Trouble,            // status is TroubleEvent
+        KeypadDisplay       // IT100::lcdDisplayContents was updated
+    };
+
+    uint16_t code;          // Command that produced the event
+    Type type;
+    uint8_t partition;      // 0 when not known
+    uint8_t zone;           // 0 when not applicable
+    uint8_t status;
+    int16_t user;           // -1 when not known
+    int64_t receivedAt;     // msecs since epoch the line was received
+};
+
+/**
+  * PanelEventConsumer
+  * Receives every PanelEvent produced by IT100
+  * Events between onSnapshotBegin() and onSnapshotComplete() are the
+  * panel's answer to a status request (001) and describe current
+  * state rather than changes
+  */
+class PanelEventConsumer
+{
+public:
+    virtual ~PanelEventConsumer() {}
+    virtual void onPanelEvent(const PanelEvent &event) = 0;
+
+    virtual void onSnapshotBegin() {}
+
+    // complete is false if the snapshot timed out or the link dropped
+    virtual void onSnapshotComplete(int64_t elapsedMsecs, bool complete) {
+        (void)elapsedMsecs; (void)complete;
+    }
+};
+
+} // namespace it100
+
+#endif // IT100EVENT_H
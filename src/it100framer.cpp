@@ -0,0 +1,111 @@
+#include "it100framer.h"
+
+#include <cstring>
+
+namespace it100 {
+
+static_assert((LineFramer::capacity & (LineFramer::capacity - 1)) == 0,
+              "LineFramer capacity must be a power of 2");
+static_assert(LineFramer::maxLineLength < LineFramer::capacity,
+              "LineFramer must hold a complete line");
+
+int LineFramer::writeAvailable() const
+{
+    uint32_t used = _writePos - _readPos;
+    uint32_t free = capacity - used;
+    uint32_t contiguous = capacity - (_writePos & mask);
+    return static_cast<int>(free < contiguous ? free : contiguous);
+}
+
+void LineFramer::commit(int bytes)
+{
+    _writePos += static_cast<uint32_t>(bytes);
+}
+
+/**
+  * nextLine(line)
+  * Search for LF from where the last call stopped; a CR before the
+  * LF is dropped. Lines too long to be IT-100 frames are discarded
+  * up to the next LF so the stream resyncs on the following line.
+  */
+bool LineFramer::nextLine(LineView &line)
+{
+    while (_scanPos != _writePos) {
+
+        // search the contiguous run up to the write position or ring end
+        uint32_t offset = _scanPos & mask;
+        uint32_t run = _writePos - _scanPos;
+        if (offset + run > static_cast<uint32_t>(capacity)) run = capacity - offset;
+
+        const char *found = static_cast<const char *>(
+                    memchr(_buffer + offset, '\n', run));
+        if (!found) {
+            _scanPos += run;
+            continue;
+        }
+
+        uint32_t lfPos = _scanPos + static_cast<uint32_t>(found - (_buffer + offset));
+        uint32_t start = _readPos;
+        uint32_t length = lfPos - start;
+
+        _scanPos = lfPos + 1;
+        _readPos = _scanPos;
+
+        if (_discarding) {
+            _discarding = false;
+            continue;
+        }
+
+        // drop CR of CR/LF
+        if (length && _buffer[(lfPos - 1) & mask] == '\r') length--;
+
+        // blank lines carry nothing
+        if (!length) continue;
+
+        if (length > static_cast<uint32_t>(maxLineLength)) {
+            _stats.overruns++;
+            continue;
+        }
+
+        _stats.bytesFramed += _readPos - start;
+        _stats.linesFramed++;
+
+        uint32_t first = start & mask;
+        if (first + length <= static_cast<uint32_t>(capacity)) {
+            line.data = _buffer + first;
+        } else {
+            // line wraps the end of the ring
+            uint32_t head = capacity - first;
+            memcpy(_scratch, _buffer + first, head);
+            memcpy(_scratch + head, _buffer, length - head);
+            line.data = _scratch;
+        }
+        line.size = static_cast<int>(length);
+        return true;
+    }
+
+    // no terminator within a frame length; this is not a line we
+    // can use, so drop what we have and skip to the next LF
+    if (_writePos - _readPos > static_cast<uint32_t>(maxLineLength)) {
+        if (!_discarding) _stats.overruns++;
+        _discarding = true;
+        _readPos = _writePos;
+    }
+
+    return false;
+}
+
+void LineFramer::endRead(int lines)
+{
+    _stats.reads++;
+    _stats.linesLastRead = lines;
+    if (lines > _stats.linesPerReadMax) _stats.linesPerReadMax = lines;
+}
+
+void LineFramer::clear()
+{
+    _readPos = _writePos = _scanPos = 0;
+    _discarding = false;
+}
+
+} // namespace it100
@@ -0,0 +1,79 @@
+#ifndef IT100FRAMER_H
+#define IT100FRAMER_H
+
+#include <cstdint>
+
+namespace it100 {
+
+/**
+  * Non-owning view of received bytes
+  * Only valid until the next call into the LineFramer that produced it
+  */
+struct LineView {
+    const char *data = nullptr;
+    int size = 0;
+
+    char at(int i) const { return data[i]; }
+    LineView mid(int from, int length = -1) const {
+        if (from > size) from = size;
+        if (length < 0 || from + length > size) length = size - from;
+        return LineView { data + from, length };
+    }
+};
+
+/**
+  * LineFramer
+  * Splits the IT-100 byte stream into CR/LF terminated lines
+  * Bytes are read straight into a fixed ring and lines are handed
+  * out as views; a line is only copied if it wraps the end of the ring
+  */
+class LineFramer
+{
+public:
+
+    static const int capacity = 4096; // must be a power of 2
+    static const int maxLineLength = 128;
+
+    struct Stats {
+        uint64_t bytesFramed = 0;   // bytes consumed as complete lines
+        uint64_t linesFramed = 0;
+        uint64_t overruns = 0;      // lines discarded for exceeding maxLineLength
+        uint64_t reads = 0;
+        int linesLastRead = 0;
+        int linesPerReadMax = 0;
+    };
+
+    // contiguous free space to read the next bytes into
+    char *writePointer() { return _buffer + (_writePos & mask); }
+    int writeAvailable() const;
+    void commit(int bytes);
+
+    // next complete line, without its terminator; false if none is buffered
+    bool nextLine(LineView &line);
+
+    // account the lines framed by one socket read
+    void endRead(int lines);
+
+    void clear();
+
+    const Stats &stats() const { return _stats; }
+
+private:
+
+    static const uint32_t mask = capacity - 1;
+
+    char _buffer[capacity];
+    char _scratch[maxLineLength];
+
+    // free running positions; physical offset is pos & mask
+    uint32_t _readPos = 0;
+    uint32_t _writePos = 0;
+    uint32_t _scanPos = 0;
+    bool _discarding = false;
+
+    Stats _stats;
+};
+
+} // namespace it100
+
+#endif // IT100FRAMER_H
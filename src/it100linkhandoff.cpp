@@ -0,0 +1,338 @@
+#include "it100linkhandoff.h"
+
+#include <QDebug>
+#include <QTimer>
+
+#include <chrono>
+#include <cstring>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace it100 {
+
+static void pinCurrentThread(int cpu)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (error)
+        qDebug() << qPrintable(QString("unable to pin it100 thread to cpu %1: %2")
+                               .arg(cpu).arg(strerror(error)));
+#else
+    Q_UNUSED(cpu)
+#endif
+}
+
+LinkHandoff::LinkHandoff(IT100 *module, PanelEventConsumer *consumer,
+                         QObject *parent) :
+    QObject(parent)
+{
+    this->module = module;
+    this->consumer = consumer;
+    module->setEventConsumer(this);
+
+    worker = new LinkHandoffWorker(this);
+
+    // built on the module thread, where the stats are consistent
+    ConnectionSupervisor *supervisor = module->supervisor();
+    connect(supervisor, &ConnectionSupervisor::reconnected, this,
+            [this, supervisor](int64_t downMsecs) {
+        emit reconnected(supervisor->name(), downMsecs, supervisor->histogramString());
+    }, Qt::DirectConnection);
+}
+
+LinkHandoff::~LinkHandoff()
+{
+    if (thread) {
+        // module and worker are deleted as the thread finishes
+        thread->quit();
+        thread->wait();
+    } else {
+        delete module;
+        delete worker;
+    }
+}
+
+void LinkHandoff::setThreaded(bool threaded, int cpu)
+{
+    if (thread) return;
+    this->cpu = threaded ? cpu : -1;
+    if (!threaded) return;
+
+    thread = new QThread(this);
+    thread->setObjectName("it100");
+    module->moveToThread(thread);
+    worker->moveToThread(thread);
+    connect(thread, &QThread::finished, module, &QObject::deleteLater);
+    connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+}
+
+void LinkHandoff::start()
+{
+    if (thread && !thread->isRunning()) {
+        if (cpu >= 0) {
+            int cpu = this->cpu;
+            connect(thread, &QThread::started, [cpu]() { pinCurrentThread(cpu); });
+        }
+        thread->start();
+    }
+    QMetaObject::invokeMethod(worker, "openModule", Qt::QueuedConnection);
+}
+
+int64_t LinkHandoff::handoffClock()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ##################
+// Module thread side
+// ##################
+
+void LinkHandoff::onPanelEvent(const PanelEvent &event)
+{
+    EventSlot slot;
+    slot.kind = EventSlot::Event;
+    slot.complete = false;
+    slot.event = event;
+    slot.elapsedMsecs = 0;
+    slot.text[0] = 0;
+
+    if (event.type == PanelEvent::KeypadDisplay) {
+        QByteArray text = module->lcdDisplayContents.toLatin1().left(maxLcdTextLength - 1);
+        memcpy(slot.text, text.constData(), text.size());
+        slot.text[text.size()] = 0;
+    }
+
+    pushEvent(slot, false);
+}
+
+void LinkHandoff::onSnapshotBegin()
+{
+    EventSlot slot;
+    slot.kind = EventSlot::SnapshotBegin;
+    slot.complete = false;
+    slot.elapsedMsecs = 0;
+    pushEvent(slot, true);
+}
+
+void LinkHandoff::onSnapshotComplete(int64_t elapsedMsecs, bool complete)
+{
+    EventSlot slot;
+    slot.kind = EventSlot::SnapshotComplete;
+    slot.complete = complete;
+    slot.elapsedMsecs = elapsedMsecs;
+    pushEvent(slot, true);
+}
+
+/**
+  * pushEvent(slot, reserved)
+  * A full ring drops the event rather than hold up the module; the
+  * state it carried is recovered by asking the panel for a status
+  * snapshot once the bridge has caught up
+  */
+bool LinkHandoff::pushEvent(EventSlot &slot, bool reserved)
+{
+    slot.pushedAt = handoffClock();
+
+    int depth = events.size();
+    bool room = reserved || depth < eventRingSize - eventRingReserve;
+    if (!room || !events.push(slot)) {
+        eventDrops++;
+        if (!resyncPending) {
+            resyncPending = true;
+            QTimer::singleShot(resyncCheckMsecs, worker, [this]() { resync(); });
+        }
+        return false;
+    }
+
+    if (depth + 1 > eventDepthMax.load(std::memory_order_relaxed))
+        eventDepthMax.store(depth + 1, std::memory_order_relaxed);
+
+    if (!eventDrainPosted.exchange(true))
+        QMetaObject::invokeMethod(this, "drainEvents", Qt::QueuedConnection);
+    return true;
+}
+
+void LinkHandoff::resync()
+{
+    if (events.size() >= eventRingSize / 2 || module->isWaitingForStatusUpdate()) {
+        QTimer::singleShot(resyncCheckMsecs, worker, [this]() { resync(); });
+        return;
+    }
+    resyncPending = false;
+    qDebug() << "it100 events were dropped; requesting status";
+    module->requestStatusSnapshot();
+}
+
+// module counters for the bridge thread, see moduleStats()
+void LinkHandoff::snapshotModuleStats()
+{
+    ModuleStats stats;
+    stats.framer = module->framerStats();
+    stats.checksumRejects = module->checksumRejectCount();
+    stats.lengthRejects = module->lengthRejectCount();
+    stats.pacer = module->transmitPacerStats();
+    stats.linkUtilization = module->linkUtilization();
+    for (int lane = 0; lane < LANE_COUNT; lane++)
+        stats.lanes[lane] = module->commandQueueStats(CommandLane(lane));
+    stats.link = module->commandLinkStats();
+
+    QMutexLocker locker(&moduleStatsLock);
+    moduleStatsSnapshot = stats;
+}
+
+void LinkHandoff::drainCommands()
+{
+    commandDrainPosted.store(false);
+
+    CommandSlot slot;
+    while (commands.pop(&slot)) {
+        commandsTaken++;
+        int64_t latency = handoffClock() - slot.pushedAt;
+        if (latency > commandLatencyMax.load(std::memory_order_relaxed))
+            commandLatencyMax.store(latency, std::memory_order_relaxed);
+
+        switch (slot.kind) {
+        case CommandSlot::ArmStay:
+            module->armStay(slot.partition);
+            break;
+        case CommandSlot::ArmAway:
+            module->armAway(slot.partition);
+            break;
+        case CommandSlot::Disarm:
+            module->disarm(slot.partition);
+            break;
+        case CommandSlot::KeySequence:
+            if (!module->sendKeySequence(QByteArray(slot.keys, slot.length)))
+                emit keySequenceRejected(slot.length);
+            break;
+        }
+    }
+}
+
+// ##################
+// Bridge thread side
+// ##################
+
+void LinkHandoff::drainEvents()
+{
+    eventDrainPosted.store(false);
+
+    EventSlot slot;
+    while (events.pop(&slot)) {
+        int64_t latency = handoffClock() - slot.pushedAt;
+        bridgeStats.events++;
+        bridgeStats.eventLatencyLastUsecs = latency;
+        if (latency > bridgeStats.eventLatencyMaxUsecs)
+            bridgeStats.eventLatencyMaxUsecs = latency;
+        bridgeStats.eventLatencyAvgUsecs = bridgeStats.eventLatencyAvgUsecs
+                ? (bridgeStats.eventLatencyAvgUsecs * 7 + latency) / 8 : latency;
+
+        switch (slot.kind) {
+        case EventSlot::Event:
+            if (slot.event.type == PanelEvent::KeypadDisplay)
+                lcdText = QString::fromLatin1(slot.text);
+            consumer->onPanelEvent(slot.event);
+            break;
+        case EventSlot::SnapshotBegin:
+            consumer->onSnapshotBegin();
+            break;
+        case EventSlot::SnapshotComplete:
+            consumer->onSnapshotComplete(slot.elapsedMsecs, slot.complete);
+            break;
+        }
+    }
+}
+
+bool LinkHandoff::pushCommand(CommandSlot &slot)
+{
+    slot.pushedAt = handoffClock();
+    if (!commands.push(slot)) {
+        bridgeStats.commandDrops++;
+        return false;
+    }
+
+    int depth = commands.size();
+    if (depth > bridgeStats.commandDepthMax) bridgeStats.commandDepthMax = depth;
+
+    if (!commandDrainPosted.exchange(true))
+        QMetaObject::invokeMethod(worker, "drainCommands", Qt::QueuedConnection);
+    return true;
+}
+
+bool LinkHandoff::armStay(int partition)
+{
+    CommandSlot slot;
+    slot.kind = CommandSlot::ArmStay;
+    slot.partition = partition;
+    slot.length = 0;
+    return pushCommand(slot);
+}
+
+bool LinkHandoff::armAway(int partition)
+{
+    CommandSlot slot;
+    slot.kind = CommandSlot::ArmAway;
+    slot.partition = partition;
+    slot.length = 0;
+    return pushCommand(slot);
+}
+
+bool LinkHandoff::disarm(int partition)
+{
+    CommandSlot slot;
+    slot.kind = CommandSlot::Disarm;
+    slot.partition = partition;
+    slot.length = 0;
+    return pushCommand(slot);
+}
+
+bool LinkHandoff::sendKeySequence(const QByteArray &keys)
+{
+    if (keys.isEmpty() || keys.size() > maxKeySequenceLength) return false;
+
+    CommandSlot slot;
+    slot.kind = CommandSlot::KeySequence;
+    slot.partition = 0;
+    slot.length = keys.size();
+    memcpy(slot.keys, keys.constData(), keys.size());
+    return pushCommand(slot);
+}
+
+LinkHandoff::Stats LinkHandoff::stats() const
+{
+    Stats stats = bridgeStats;
+    stats.eventDrops = eventDrops.load();
+    stats.eventDepthMax = eventDepthMax.load();
+    stats.commands = commandsTaken.load();
+    stats.commandLatencyMaxUsecs = commandLatencyMax.load();
+    return stats;
+}
+
+LinkHandoff::ModuleStats LinkHandoff::moduleStats() const
+{
+    QMutexLocker locker(&moduleStatsLock);
+    return moduleStatsSnapshot;
+}
+
+// ##########
+// Worker
+// ##########
+
+void LinkHandoffWorker::openModule()
+{
+    handoff->module->open();
+
+    QTimer *statsTimer = new QTimer(this);
+    connect(statsTimer, &QTimer::timeout,
+            this, &LinkHandoffWorker::snapshotModuleStats);
+    statsTimer->start(LinkHandoff::statsSnapshotMsecs);
+}
+
+} // namespace it100
@@ -0,0 +1,203 @@
+#ifndef IT100LINKHANDOFF_H
+#define IT100LINKHANDOFF_H
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QByteArray>
+#include <QString>
+
+#include <atomic>
+
+#include "it100.h"
+#include "it100spscring.h"
+
+namespace it100 {
+
+class LinkHandoffWorker;
+
+/**
+  * LinkHandoff
+  * Runs an IT100 - transport, framer and command window - on its own
+  * thread so reading the panel never waits on MQTT, graylog or log
+  * formatting. Events come to the bridge thread through one SpscRing,
+  * commands go back through another; the owner only talks to this
+  * class once start() has been called
+  */
+class LinkHandoff : public QObject, public PanelEventConsumer
+{
+    Q_OBJECT
+public:
+
+    static const int eventRingSize = 256;
+    static const int commandRingSize = 64;
+
+    // slots kept back for snapshot begin/complete, which must not be
+    // dropped or the bridge would stage retained state indefinitely
+    static const int eventRingReserve = 8;
+
+    static const int maxLcdTextLength = 40;
+
+    // after a drop, how often to check the ring has room for a resync
+    static const int resyncCheckMsecs = 250;
+
+    // how often the module thread copies out its counters
+    static const int statsSnapshotMsecs = 1000;
+
+    struct Stats {
+        uint64_t events = 0;            // delivered to the consumer
+        uint64_t eventDrops = 0;        // ring full; a status snapshot follows
+        int eventDepthMax = 0;
+        int64_t eventLatencyLastUsecs = 0;  // push to delivery
+        int64_t eventLatencyMaxUsecs = 0;
+        int64_t eventLatencyAvgUsecs = 0;   // moving average
+        uint64_t commands = 0;          // taken by the module thread
+        uint64_t commandDrops = 0;
+        int commandDepthMax = 0;
+        int64_t commandLatencyMaxUsecs = 0;
+    };
+
+    // the module's own counters, which only its thread may read
+    struct ModuleStats {
+        LineFramer::Stats framer;
+        uint64_t checksumRejects = 0;
+        uint64_t lengthRejects = 0;
+        TransmitPacer::Stats pacer;
+        double linkUtilization = 0;     // share of the serial rate used
+        CommandQueue::Stats lanes[LANE_COUNT];
+        IT100::CommandLinkStats link;
+    };
+
+    // takes ownership of module; consumer receives its events on the
+    // thread this object lives on
+    LinkHandoff(IT100 *module, PanelEventConsumer *consumer,
+                QObject *parent = nullptr);
+    ~LinkHandoff();
+
+    // before start(): own thread or not, and the cpu to pin it to
+    void setThreaded(bool threaded, int cpu = -1);
+
+    void start();
+
+    // false if the command ring is full
+    bool armStay(int partition = 1);
+    bool armAway(int partition = 1);
+    bool disarm(int partition = 1);
+    bool sendKeySequence(const QByteArray &keys);
+
+    // as of the last KeypadDisplay event delivered
+    QString lcdDisplayContents() const { return lcdText; }
+
+    Stats stats() const;
+
+    // as of the last copy made on the module thread
+    ModuleStats moduleStats() const;
+
+    // module thread side
+    void onPanelEvent(const PanelEvent &event) override;
+    void onSnapshotBegin() override;
+    void onSnapshotComplete(int64_t elapsedMsecs, bool complete) override;
+
+signals:
+
+    // the module's link came back; histogram as ConnectionSupervisor
+    void reconnected(QString name, qint64 downMsecs, QString histogram);
+
+    // the module would not take a key sequence, eg. one still running
+    void keySequenceRejected(int keys);
+
+private slots:
+
+    void drainEvents();
+
+private:
+
+    friend class LinkHandoffWorker;
+
+    struct EventSlot {
+        enum Kind : uint8_t { Event, SnapshotBegin, SnapshotComplete };
+        Kind kind;
+        bool complete;
+        PanelEvent event;
+        int64_t elapsedMsecs;
+        int64_t pushedAt;       // usecs, handoffClock()
+        char text[maxLcdTextLength];
+    };
+
+    struct CommandSlot {
+        enum Kind : uint8_t { ArmStay, ArmAway, Disarm, KeySequence };
+        Kind kind;
+        uint8_t partition;
+        uint8_t length;
+        char keys[maxKeySequenceLength];
+        int64_t pushedAt;
+    };
+
+    static int64_t handoffClock();
+
+    bool pushEvent(EventSlot &slot, bool reserved);
+    bool pushCommand(CommandSlot &slot);
+    void drainCommands();
+    void resync();
+    void snapshotModuleStats();
+
+    IT100 *module;
+    PanelEventConsumer *consumer;
+    LinkHandoffWorker *worker;
+
+    QThread *thread = nullptr;
+    int cpu = -1;
+
+    SpscRing<EventSlot, eventRingSize> events;
+    SpscRing<CommandSlot, commandRingSize> commands;
+
+    // set by the producer when it posts a drain, cleared by the
+    // consumer before it empties the ring
+    std::atomic<bool> eventDrainPosted { false };
+    std::atomic<bool> commandDrainPosted { false };
+
+    // module thread only
+    bool resyncPending = false;
+
+    QString lcdText;
+
+    // written on the bridge thread
+    Stats bridgeStats;
+
+    // written on the module thread
+    std::atomic<uint64_t> eventDrops { 0 };
+    std::atomic<int> eventDepthMax { 0 };
+    std::atomic<uint64_t> commandsTaken { 0 };
+    std::atomic<int64_t> commandLatencyMax { 0 };
+
+    // copied whole under the lock, so a reader never sees half of one
+    mutable QMutex moduleStatsLock;
+    ModuleStats moduleStatsSnapshot;
+
+};
+
+/**
+  * LinkHandoffWorker
+  * Lives on the module thread and feeds it the command ring
+  */
+class LinkHandoffWorker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LinkHandoffWorker(LinkHandoff *handoff) : handoff(handoff) {}
+
+public slots:
+
+    void openModule();
+    void drainCommands() { handoff->drainCommands(); }
+    void snapshotModuleStats() { handoff->snapshotModuleStats(); }
+
+private:
+
+    LinkHandoff *handoff;
+
+};
+
+} // namespace it100
+
+#endif // IT100LINKHANDOFF_H
@@ -1,62 +1,37 @@
 #include "it100message.h"
 
+#include <cstring>
+
 namespace it100 {
 
-It100Message::It100Message(QByteArray command, QByteArray data, QObject *parent) :
-    QObject(parent)
+It100Message::It100Message(Command command, const char *data, int length)
 {
-    // default to invalid message state
-    valid = false;
-
-    this->command = command;
-    this->data = data;
-
-    generatePacket();
-}
+    _command = command;
 
-int It100Message::generatePacket()
-{
+    // left invalid; the queue refuses it
+    if (length < 0 || length > maxDataLength) return;
 
     // Start off packet with command
-    packetData = command;
+    writeCommandCode(command, _packet);
 
     // Append data
-    if (data.size()>0) packetData.append(data);
+    if (length > 0) memcpy(_packet + 3, data, length);
+    int size = 3 + length;
 
     // Append calculated checksum from current payload
-    packetData.append(generateChecksum(&packetData));
+    writeChecksum(checksum(_packet, size), _packet + size);
+    size += 2;
 
     // Append token EOL
-    packetData.append("\r\n");
-
-    valid = true;
-    return false;
+    _packet[size++] = '\r';
+    _packet[size++] = '\n';
 
+    _size = static_cast<uint8_t>(size);
 }
 
-QByteArray It100Message::generateChecksum(QByteArray *data)
+It100Message::It100Message(Command command, const QByteArray &data) :
+    It100Message(command, data.constData(), data.size())
 {
-    /* Count up HEX (as int) bytes */
-    QString hexint = QString(data->toHex());
-    int count = 0;
-    for (int x = 0; x < data->size(); x++) {
-        // hexint = QString(QByteArray(status.at(x)).toHex());
-        bool ok;
-        count += hexint.mid((x * 2),2).toUInt(&ok,16);
-    }
-
-    // Convert number (int) to HEX Ascii for chopping up
-    QString asciiint = QString().setNum(count,16);
-
-    // QByteArray checksum = QByteArray().fromHex();
-    // TODO, still need to truncate this to 8 bits!
-
-    // Create DCS's silly checksum
-    QByteArray checksum;
-    checksum.append(asciiint.mid(asciiint.size()-2,1).toUpper());
-    checksum.append(asciiint.mid(asciiint.size()-1,1).toUpper());
-
-    return checksum;
 }
 
 } // namespace it100
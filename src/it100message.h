@@ -1,33 +1,41 @@
 #ifndef IT100MESSAGE_H
 #define IT100MESSAGE_H
 
-#include <QObject>
+#include <QByteArray>
+
+#include "it100commands.h"
 
 namespace it100 {
 
-class It100Message : public QObject
+/**
+  * It100Message
+  * One outbound command, formatted once into a fixed buffer as the
+  * complete packet: code, data, checksum and CR/LF
+  * Plain value so it can be held in the command queue without
+  * allocation
+  */
+class It100Message
 {
-    Q_OBJECT
 public:
-    explicit It100Message(QByteArray command, QByteArray data = "", QObject *parent = 0);
-
-    QByteArray *packet() { return &packetData; }
-    bool isValid() { return valid; }
 
-private:
+    // longest data field we send; set time and date is 10
+    static const int maxDataLength = 32;
+    static const int maxPacketLength = 3 + maxDataLength + 2 + 2;
 
-    QByteArray command;
-    QByteArray data;
+    It100Message() {}
+    It100Message(Command command, const char *data, int length);
+    explicit It100Message(Command command, const QByteArray &data = QByteArray());
 
-    QByteArray packetData;
-    bool valid;
+    Command command() const { return _command; }
+    const char *packet() const { return _packet; }
+    int size() const { return _size; }
+    bool isValid() const { return _size > 0; }
 
-    int generatePacket();
-    QByteArray generateChecksum(QByteArray *data);
-
-signals:
+private:
 
-public slots:
+    Command _command = CMD_INVALID;
+    uint8_t _size = 0;
+    char _packet[maxPacketLength];
 
 };
 
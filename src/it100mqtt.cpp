@@ -26,27 +26,43 @@ It100Mqtt::It100Mqtt(QString settingsFile, QObject *parent) :
         debugMode = settings.value("debug", false).toBool();
         if (debugMode) qDebug() <<
          "debug mode enabled!";
+        int statsSecs = settings.value("stats_secs", 300).toInt();
         
-        settings.beginGroup("it100");
-        it100RemoteHost = settings.value("host", QString()).toString();
-        it100RemotePort = settings.value("port", 0).toInt(); // quint16
-        it100UserCode = settings.value("user_code", QString()).toString();
-        settings.endGroup();
-        
-        if (it100RemotePort == 0) {
-            qDebug() << "error: unable to load configuration; exiting";
-            _failed = true;
-            return;
-        };
-
         settings.beginGroup("mqtt");
         m_mqttRemoteHost = settings.value("host", QString()).toString();
         m_mqttRemotePort = settings.value("port", QString()).toInt();
         mqttClientName = settings.value("client_name",
                                          QString("it100")).toString();
-        mqttTopicPrefix = settings.value("topic_prefix",
-                                          QString("alarm/")).toString();
-        mqttTopicPrefix = mqttTopicPrefix.append(mqttClientName);
+        QString topicBase = settings.value("topic_prefix",
+                                           QString("alarm/")).toString();
+        mqttTopicPrefix = topicBase + mqttClientName;
+        mqttLatencyMode = settings.value("latency_mode", false).toBool();
+        int inflightWindow = settings.value("inflight_window", 16).toInt();
+        int retransmitSecs = settings.value("retransmit_secs", 10).toInt();
+        int coalesceBytes = settings.value("coalesce_bytes", 16384).toInt();
+        int coalesceMsecs = settings.value("coalesce_msecs", 0).toInt();
+        settings.endGroup();
+
+        // Spool for while the broker is unreachable
+        settings.beginGroup("spool");
+        spool.setMemoryLimit(settings.value("memory_kb",
+                                            PublishSpool::defaultMemoryLimit / 1024).toInt() * 1024);
+        const char *classKeys[] = { "events", "state", "log" };
+        for (int topicClass = 0; topicClass < PublishSpool::ClassCount; topicClass++) {
+            PublishSpool::Policy policy;
+            QVariant value = settings.value(classKeys[topicClass]);
+            if (!value.isValid()) continue;
+            if (PublishSpool::policyFromString(value.toString(), &policy))
+                spool.setPolicy(PublishSpool::TopicClass(topicClass), policy);
+            else
+                qDebug() << qPrintable(QString("spool: unknown policy %1 for %2")
+                                       .arg(value.toString()).arg(classKeys[topicClass]));
+        }
+        QString journalFile = settings.value("journal", QString()).toString();
+        if (!journalFile.isEmpty() &&
+                !spool.openJournal(journalFile, settings.value("journal_mb", 16).toLongLong()
+                                   * 1024 * 1024))
+            qDebug() << "spool: journal unavailable; holding events in memory only";
         settings.endGroup();
 
         // Graylog
@@ -70,57 +86,87 @@ It100Mqtt::It100Mqtt(QString settingsFile, QObject *parent) :
         }
         settings.endGroup();
 
-        it100 = new it100::IT100(it100::IFACE_IPSERIAL,debugMode);
+        // [it100] is published under the client name; each further
+        // [it100-name] panel under its own name, same client
+        foreach (QString group, settings.childGroups()) {
+            QString name;
+            if (group == "it100") name = mqttClientName;
+            else if (group.startsWith("it100-")) name = group.mid(6);
+            else continue;
+
+            PanelBridge *bridge = new PanelBridge(this, name, topicBase + name, this);
+            if (!bridge->configure(settings, group, debugMode, &socketTuning)) {
+                qDebug() << qPrintable(QString("error: unable to load [%1]; exiting")
+                                       .arg(group));
+                _failed = true;
+                return;
+            }
+            panels.append(bridge);
+        }
+        if (panels.isEmpty()) {
+            qDebug() << "error: unable to load configuration; exiting";
+            _failed = true;
+            return;
+        }
+        qDebug() << qPrintable(QString("bridging %1 panel(s)").arg(panels.count()));
 
         // Configure MQTT
         client = new QMQTT::Client();
         client->setClientId(mqttClientName);
+        client->setInFlightWindow(inflightWindow);
+        client->setRetransmitTimeout(retransmitSecs * 1000);
+        client->setWriteCoalescing(coalesceBytes, coalesceMsecs);
         //client->setUsername("user");
         //client->setPassword("password");
-        mId = 0; // track sequential message ids
         QMQTT::Will *will = new QMQTT::Will(QString("%1/availability")
                 .arg(mqttTopicPrefix),"offline",QOS_1,true);
         client->setWill(will);
 
-        connect(client, &QMQTT::Client::connected,
-                this, &It100Mqtt::onMqttConnect);
+        router = new QMQTT::Router(client);
+        foreach (PanelBridge *bridge, panels) bridge->route(router);
+
+        // the session is up at CONNACK, not when the socket connects
+        connect(client, &QMQTT::Client::connacked,
+                this, &It100Mqtt::onMqttConnack);
         connect(client, &QMQTT::Client::disconnected,
                 this, &It100Mqtt::onMqttDisconnected);
-        connect(client, &QMQTT::Client::received,
-                this, &It100Mqtt::onMqttMessageReceived);
-
-        // Apply IT100 Settings
-        it100->setUserCode(it100UserCode.toInt());
-        if (debugMode) 
-            qDebug() << qPrintable(QString("user code is: %1").arg(it100UserCode.toInt()));
-
-        connect(it100, &it100::IT100::connected,
-                this, &It100Mqtt::onIt100Connected);
-        connect(it100, &it100::IT100::disconnected,
-                this, &It100Mqtt::onIt100Disconnected);
-        connect(it100, &it100::IT100::communicationsBegin,
-                this, &It100Mqtt::onIt100CommunicationsBegin);
-        connect(it100, &it100::IT100::communicationsTimeout,
-                this, &It100Mqtt::onIt100CommunicationsTimeout);
-        connect(it100, &it100::IT100::userEvent,
-                this, &It100Mqtt::processIt100UserEvent);
-        connect(it100, &it100::IT100::partitionStatusChanged,
-                this, &It100Mqtt::onIt100PartitionStatusChange);
-        connect(it100, &it100::IT100::zoneStatusChanged,
-                this, &It100Mqtt::onIt100ZoneStatusChange);
-        connect(it100, &it100::IT100::virtualKeypadDisplayUpdate,
-                this, &It100Mqtt::onIt100VirtualKeypadDisplayUpdate);
-        connect(it100, &it100::IT100::troubleEvent,
-                this, &It100Mqtt::onIt100TroubleEvent);
-        connect(it100, &it100::IT100::partitionArmedDescriptive,
-                this, &It100Mqtt::onIt100PartitionArmedDescriptive);
-
-        // load from disk
-        loadUserSlots();
+        connect(client, &QMQTT::Client::error,
+                this, &It100Mqtt::onMqttError);
+        connect(client, &QMQTT::Client::pubacked,
+                this, &It100Mqtt::onMqttPubacked);
+        if (mqttLatencyMode) {
+            connect(client, &QMQTT::Client::socketConnected,
+                    this, &It100Mqtt::onMqttSocketConnected);
+            qDebug() << qPrintable(QString("mqtt latency mode: %1")
+                                   .arg(socketTuning.describe()));
+        }
+
+        // an unreachable broker only reports error(); one that turns
+        // the session down says so in its CONNACK
+        mqttSupervisor = new ConnectionSupervisor("mqtt", [this]() {
+            client->connect();
+        }, this);
+
+        // runs from the connect to CONNACK, so it covers a broker that
+        // takes the connection but never answers
+        mqttSupervisor->setAttemptTimeout([this]() { client->disconnect(); });
+
+        connect(mqttSupervisor, &ConnectionSupervisor::reconnected,
+                this, [this](int64_t downMsecs) {
+            onReconnected(mqttSupervisor->name(), downMsecs,
+                          mqttSupervisor->histogramString());
+        });
+
+        // Periodic Statistics Report
+        if (statsSecs > 0) {
+            statsTimer = new QTimer(this);
+            connect(statsTimer, &QTimer::timeout, this, &It100Mqtt::reportStats);
+            statsTimer->start(statsSecs * 1000);
+        }
 
         // Go ahead and connect
         connectToMqttBroker(m_mqttRemoteHost, m_mqttRemotePort);
-        connectToIt100(it100RemoteHost, it100RemotePort);
+        connectToIt100();
 
         graylog->sendMessage("Starting it100-mqtt service", LevelNotice);
     }
@@ -129,9 +175,12 @@ It100Mqtt::It100Mqtt(QString settingsFile, QObject *parent) :
 
 void It100Mqtt::updateServiceStatus()
 {
-    // is IT100 module communicating correctly?
-    if (it100->getStatus() == COMP_STATUS_OK &&
-            mqttStatus == COMP_STATUS_OK) {
+    // are all IT100 modules communicating correctly?
+    bool panelsOk = true;
+    foreach (PanelBridge *bridge, panels)
+        if (bridge->status() != COMP_STATUS_OK) panelsOk = false;
+
+    if (panelsOk && mqttStatus == COMP_STATUS_OK) {
         sd_notify (0, "READY=1");
     } else {
         // todo: determine difference between starting and failed
@@ -139,42 +188,36 @@ void It100Mqtt::updateServiceStatus()
     }
 }
 
-QString It100Mqtt::nameFromUserCodeSlot(int32_t user)
+// CONNACK return codes, MQTT 3.1.1 section 3.2.2.3
+static QString connackReason(quint8 ack)
 {
-    loadUserSlots();
-
-    if (!userSlots.contains(user)) return "unknown";
-
-    return userSlots.value(user);
-}
-
-bool It100Mqtt::loadUserSlots()
-{
-    userSlots.clear();
-    QSettings settings(configFile,QSettings::IniFormat,this);
-    settings.beginGroup("users");
-    foreach ( auto key, settings.childKeys() ) {
-        // make sure we dont try to add anything without a key as this is likely
-        // a mistake
-        if (key.toInt() <= 0 || key.toInt() > 1000) continue;
-
-        userSlots.insert(key.toInt(),settings.value(key).toString());
-        qDebug() << "added" << key.toInt() << settings.value(key).toString();
+    switch (ack) {
+    case 1: return "unacceptable protocol version";
+    case 2: return "client identifier rejected";
+    case 3: return "server unavailable";
+    case 4: return "bad user name or password";
+    case 5: return "not authorized";
+    default: return QString("return code %1").arg(ack);
     }
-    settings.endGroup();
 }
 
-void It100Mqtt::onIt100VirtualKeypadDisplayUpdate()
+/**
+  * onMqttConnack(ack)
+  * A refused session counts as a failed attempt: drop the socket and
+  * let the supervisor back off before the next one
+  */
+void It100Mqtt::onMqttConnack(quint8 ack)
 {
-	// send as QOS 1 (QOS 2 not supported by RabbitMQ MQTT)
-	// Retained topic for late joining clients
-    writeMqtt(QString("%1/keypad_lcd_data").arg(mqttTopicPrefix),
-              it100->lcdDisplayContents, QOS_1, true);
-}
-
+    if (ack != 0) {
+        QString reason = connackReason(ack);
+        qDebug() << qPrintable(QString("mqtt: broker refused the session: %1").arg(reason));
+        graylog->sendMessage(QString("it100-mqtt broker refused the session: %1")
+                             .arg(reason), LevelError);
+        mqttSupervisor->linkDown();
+        client->disconnect();
+        return;
+    }
 
-void It100Mqtt::onMqttConnect()
-{
     // Subscribe to commands as QOS 2
     // QoS2, Exactly once: The message is always delivered exactly once.
     // The message must be stored locally at the sender, until the sender
@@ -184,130 +227,220 @@ void It100Mqtt::onMqttConnect()
     // A more sophisticated handshaking and acknowledgement sequence is used
     // than for QoS1 to ensure no duplication of messages occurs.
     //
-    client->subscribe(QString("%1/command").arg(mqttTopicPrefix), QOS_1);
+    router->resubscribe();
+    replaySpool();
+    mqttSupervisor->linkUp();
     mqttStatus = COMP_STATUS_OK;
     updateServiceStatus();
     // writeMqtt(QString("%1/partition/1/arm_status").arg(mqttTopicPrefix), "unknown", QOS_1, true);
 
 }
 
+/**
+  * replaySpool()
+  * Publish what was held while the broker was away, oldest first, and
+  * report how much went straight out, how much is still held behind
+  * the QoS 1 window and how long the oldest waited
+  */
+void It100Mqtt::replaySpool()
+{
+    if (!spool.depth()) return;
+
+    qint64 oldestMsecs = spool.oldestAgeMsecs();
+    uint64_t dropped = spool.stats().dropped - spoolDroppedReported;
+    spoolDroppedReported = spool.stats().dropped;
+
+    int replayed = drainSpool();
+    int held = spool.depth();
+
+    QString report = QString("{ \"replayed\":%1, \"held\":%2, \"oldest_ms\":%3, \"dropped\":%4 }")
+            .arg(replayed).arg(held).arg(oldestMsecs).arg(dropped);
+    writeMqtt(QString("%1/spool").arg(mqttTopicPrefix).toUtf8().constData(),
+              report.toUtf8().constData(), QOS_1);
+    graylog->sendMessage(QString("it100-mqtt replayed %1 spooled publishes, %2 still held; "
+                                 "oldest %3 ms, %4 dropped")
+                         .arg(replayed).arg(held).arg(oldestMsecs).arg(dropped),
+                         dropped ? LevelError : LevelNotice);
+}
+
+// as far as the QoS 1 window allows; the rest follows PUBACKs
+// Returns the number published
+int It100Mqtt::drainSpool()
+{
+    int published = 0;
+    PublishSpool::Entry entry;
+    while (client->isConnected() && !client->inFlightFull() && spool.takeNext(&entry)) {
+        if (entry.retain && !retainedCache.shouldSend(entry.topic.name, entry.payload))
+            continue;
+        publish(entry.topic, std::move(entry.payload), QosLevel(entry.qos), entry.retain);
+        published++;
+    }
+    if (!spool.depth()) sd_notify(0, "STATUS=");
+    return published;
+}
+
+// spool depth and age for systemctl status, at most once a second
+void It100Mqtt::updateSpoolStatus()
+{
+    if (spoolStatusTimer.isValid() && spoolStatusTimer.elapsed() < 1000) return;
+    spoolStatusTimer.start();
+    sd_notify(0, QString("STATUS=%1 publishes spooled (%2 bytes in memory, "
+                         "%3 in journal), oldest %4 ms, %5 dropped; %6 in flight")
+              .arg(spool.depth()).arg(spool.memoryBytes()).arg(spool.journalBytes())
+              .arg(spool.oldestAgeMsecs()).arg(spool.stats().dropped)
+              .arg(client ? client->inFlight() : 0)
+              .toUtf8().constData());
+}
+
 void It100Mqtt::onMqttDisconnected()
 {
-    QTimer::singleShot(1000,this,&It100Mqtt::reconnectTimerTimeout);
+    // whatever was in flight may be lost; resend every value next time
+    retainedCache.invalidate();
+    mqttSupervisor->linkDown();
     graylog->sendMessage("it100-mqtt mqtt disconnected", LevelNotice);
     mqttStatus = COMP_STATUS_FAILED;
     updateServiceStatus();
 }
 
-void It100Mqtt::reconnectTimerTimeout()
+void It100Mqtt::onMqttPubacked(quint8 type, quint16 msgid)
 {
-    connectToMqttBroker(m_mqttRemoteHost, m_mqttRemotePort);
+    if (type != PUBACK) return;
+    retainedCache.acknowledged(msgid);
+    // a window slot is free
+    if (spool.depth()) drainSpool();
 }
 
+// options go on before CONNECT is written
+void It100Mqtt::onMqttSocketConnected(qintptr descriptor)
+{
+    QStringList failed = socketTuning.apply(descriptor);
+    if (!failed.isEmpty())
+        qDebug() << qPrintable(QString("mqtt: could not set %1")
+                               .arg(failed.join(", ")));
+}
 
-void It100Mqtt::onMqttMessageReceived(QMQTT::Message message)
+// errors on a live session are followed by disconnected(); only a
+// failed connect needs reporting from here
+void It100Mqtt::onMqttError(QAbstractSocket::SocketError error)
 {
-    QString payload = QString(message.payload()).toLower();
-
-    QString logMessage = QString("Received MQTT Message: %1 %2 (id=%3;qos=%4)")
-            .arg(QString(message.topic()))
-            .arg(payload)
-            .arg(message.id())
-            .arg(message.qos());
-
-    graylog->sendMessage(logMessage, LevelDebug);
-    writeLog(logMessage);
-
-    if (message.topic() == QString("%1/command").arg(mqttTopicPrefix)) {
-        if (payload == "arm" || payload == "arm_away" || payload == "arm_stay") {
-            it100->armAway();
-            writeLog("requested to arm", LOG_LEVEL_DEBUG);
-            graylog->sendMessage("Requested to ARM; Arming", LevelNotice);
-        }
-        if (payload == "disarm") {
-            it100->disarm();
-            writeLog("requested to disarm", LOG_LEVEL_DEBUG);
-            graylog->sendMessage("Requested to DISARM, Disarming", LevelNotice);
-        } 
-        if (payload.length() == 1) {
-
-            // SINGLE CHARACTER -- KEYPRESS
-            // Some operations require a long keypress (> 1.5 seconds)
-            // To accomodate this, ALL keypresses must be followed by a keybreak ('^')
-            // To generate a long keypress, insert a 1.5 second delay before sending
-            // the keybreak
-
-            uint ascii = (uint)message.payload().at(0);
-
-            // ALLOW ONLY
-            // 0 THROUGH 9
-            // *,#,<,>
-            // a through e, F,A,P
-            if (((ascii >= 48) && (ascii <= 57)) ||
-                    (ascii == 0x2a) ||
-                    (ascii == 0x23) ||
-                    (ascii == 0x3c) ||
-                    (ascii == 0x3e) ||
-                    ((ascii >= 0x61) && (ascii <= 0x65)) ||
-                    (ascii == 0x46)  ||
-                    (ascii == 0x41)  ||
-                    (ascii == 0x50)) {
-                        it100->sendCommand(it100::CMD_KEY_PRESSED_VIRT,
-                                           message.payload());
-                        it100->sendCommand(it100::CMD_KEY_PRESSED_VIRT,
-                                           QByteArray("^")); // keybreak
-                    }
+    if (debugMode) qDebug() << qPrintable(
+        QString("mqtt socket error %1").arg(static_cast<int>(error)));
+    if (!client->isConnected()) mqttSupervisor->linkDown();
+}
 
-        }
-        //else if (message.payload().toInt()) { // is command alpha?
-        //}
-
-        else {
-            QString logMessage = QString("Command not understood: %1")
-                    .arg(payload);
-            graylog->sendMessage(logMessage, LevelError);
-            writeLog(logMessage, LOG_LEVEL_ERROR);
-        }
-    }
+
+void It100Mqtt::onReconnected(QString name, qint64 downMsecs, QString histogram)
+{
+    graylog->sendMessage(QString("it100-mqtt %1 reconnected after %2 ms; "
+                                 "time to reconnect %3")
+                         .arg(name).arg(downMsecs).arg(histogram), LevelNotice);
 }
 
-void It100Mqtt::writeMqtt(const char *topic, const char *message,
+/**
+  * writeMqtt(topic, payload, qos, retain)
+  * Returns false if a retained message was dropped because the broker
+  * already acknowledged the same value for the topic. Held in the
+  * spool until the broker has accepted the session, while the QoS 1
+  * window is full or while older publishes are still spooled; log
+  * topics are not held behind those
+  */
+bool It100Mqtt::writeMqtt(const PublishTopic &topic, QByteArray payload,
                           QosLevel qos, bool retain)
 {
-    QMQTT::Message msg(mId++,topic,message,qos,retain);
-    client->publish(msg);
+    if (retain && !retainedCache.shouldSend(topic.name, payload)) return false;
+
+    bool hold = !client || !client->isConnected() || mqttStatus != COMP_STATUS_OK ||
+            (qos == QOS_1 && client->inFlightFull()) ||
+            (spool.depth() && PublishSpool::classify(topic, retain) != PublishSpool::ClassLog);
+    if (hold) {
+        bool spooled = spool.enqueue(topic, std::move(payload), qos, retain);
+        updateSpoolStatus();
+        return spooled;
+    }
+
+    publish(topic, std::move(payload), qos, retain);
+    return true;
 }
 
-void It100Mqtt::writeMqtt(const char *topic, QString message,
-                          QosLevel qos, bool retain)
+// straight to the socket; the payload then moves into the cache
+void It100Mqtt::publish(const PublishTopic &topic, QByteArray payload,
+                        QosLevel qos, bool retain)
 {
-    writeMqtt(topic, message.toStdString().c_str(), qos, retain);
+    uint64_t allocations = AllocationCounter::count();
+    quint16 id = client->publishEncoded(topic.encoded, payload, qos, retain);
+    if (retain) retainedCache.sent(topic.name, std::move(payload), id, qos);
+
+    publishStats.publishes++;
+    publishStats.allocations += AllocationCounter::count() - allocations;
+    if (debugMode && publishStats.publishes % 1000 == 0) reportPublishStats();
 }
 
-void It100Mqtt::writeMqtt(QString topic, const char *message,
-                          QosLevel qos, bool retain)
+// how well publishes are batched into socket writes, how many
+// retained publishes the cache let through, and how the QoS 1 window
+// is holding up
+void It100Mqtt::reportPublishStats()
 {
-    writeMqtt(topic.toStdString().c_str(), message, qos, retain);
+    QMQTT::Network::Stats writes = client->writeStats();
+    uint64_t events = 0;
+    foreach (PanelBridge *bridge, panels) events += bridge->handoff()->stats().events;
+
+    QString report = QString("%1 publishes; %2 frames per socket write (at most %3), "
+                             "%4 socket writes per panel event")
+            .arg(publishStats.publishes)
+            .arg(writes.flushes ? double(writes.frames) / writes.flushes : 0)
+            .arg(writes.framesPerFlushMax)
+            .arg(events ? double(writes.flushes) / events : 0);
+    if (AllocationCounter::enabled())
+        report += QString(", %1 allocations per publish")
+                .arg(double(publishStats.allocations) / publishStats.publishes);
+    qDebug() << qPrintable(report);
+
+    const RetainedCache::Stats &retained = retainedCache.stats();
+    qDebug() << qPrintable(QString("retained: %1 sent, %2 suppressed, %3 acknowledged, "
+                                   "%4 invalidations")
+                           .arg(retained.sent)
+                           .arg(retained.suppressed)
+                           .arg(retained.acknowledged)
+                           .arg(retained.invalidations));
+
+    QMQTT::Client::InFlightStats inflight = client->inFlightStats();
+    qDebug() << qPrintable(QString("in flight: %1 now, at most %2 of %3; %4 acked, "
+                                   "%5 retransmits, %6 unknown acks; "
+                                   "ack %7 ms last, %8 ms avg, %9 ms max")
+                           .arg(client->inFlight())
+                           .arg(inflight.depthMax)
+                           .arg(client->inFlightWindow())
+                           .arg(inflight.acked)
+                           .arg(inflight.retransmits)
+                           .arg(inflight.unknownAcks)
+                           .arg(inflight.ackLatencyLastMsecs)
+                           .arg(inflight.ackLatencyAvgMsecs)
+                           .arg(inflight.ackLatencyMaxMsecs));
 }
 
-void It100Mqtt::writeMqtt(QString topic, QString message,
-                          QosLevel qos, bool retain)
+// publishing, then each panel's handoff and module
+void It100Mqtt::reportStats()
 {
-    writeMqtt(topic.toStdString().c_str(),
-              message.toStdString().c_str(), qos, retain);
+    if (publishStats.publishes) reportPublishStats();
+    foreach (PanelBridge *bridge, panels) bridge->reportStats();
 }
 
+bool It100Mqtt::writeMqtt(const char *topic, const char *message,
+                          QosLevel qos, bool retain)
+{
+    return writeMqtt(PublishTopic(QString(topic)), QByteArray(message), qos, retain);
+}
 
 void It100Mqtt::onTestTimerTimeout()
 {
 
 }
 
-// Connect it100 to remote tcp/ip host
+// Connect each it100 through its configured transport
 //
-int It100Mqtt::connectToIt100(QHostAddress host, qint16 port)
+int It100Mqtt::connectToIt100()
 {
-    it100->open(host,port);
+    foreach (PanelBridge *bridge, panels) bridge->open();
     return false;
 }
 
@@ -318,7 +451,7 @@ int It100Mqtt::connectToMqttBroker(QHostAddress host, qint16 port)
     // needing to clean session to prevent duplicates
     // for the time being
     client->setCleansess(true);
-    client->connect();
+    mqttSupervisor->start();
 
     writeLog("it100 Started", LOG_LEVEL_NOTICE);
 
@@ -332,454 +465,20 @@ int It100Mqtt::connectToMqttBroker(QHostAddress host, qint16 port)
     return false;
 }
 
-void It100Mqtt::onIt100Connected()
-{
-    // This is a TCP connection only and does not infer
-    // good communications with the module
-    // See ::onIt100CommunicationsBegin() for this
-    writeMqtt(QString("client/%1").arg(mqttClientName),
-              "{ \"connected:\" : \"true\" }", QOS_1, true);
-    writeLog(QString("Connected to IT100 at %1:%2")
-             .arg(it100->remoteHostAddress.toString())
-             .arg(it100->remoteHostPort), LOG_LEVEL_DEBUG);
-    graylog->sendMessage("Connected to it100 via tcp", LevelInformational);
-}
-
-void It100Mqtt::onIt100Disconnected()
-{
-    writeLog(QString("DISCONNECTED from IT100 at %1:%2")
-             .arg(it100->remoteHostAddress.toString())
-             .arg(it100->remoteHostPort), LOG_LEVEL_DEBUG);
-    graylog->sendMessage("Disconnected from it100 via tcp", LevelNotice);
-}
-
-void It100Mqtt::onIt100CommunicationsBegin()
-{
-    // writeMqtt(QString("client-status/%1").arg(mqttClientName), "{ \"connected:" : true", QOS_1, true);
-    writeMqtt(QString("%1/event").arg(mqttTopicPrefix), "it100 module is communicating");
-    writeMqtt(QString("%1/availability").arg(mqttTopicPrefix),"online",QOS_1,true);
-    writeLog("IT-100 is communicating", LOG_LEVEL_NOTICE);
-    graylog->sendMessage("it100 module is communicating", LevelNotice);
-    
-    updateServiceStatus();
-}
-
-void It100Mqtt::onIt100CommunicationsTimeout()
-{
-    // writeMqtt(QString("status/%1").arg(mqttClientName),"fault",QOS_1,true);
-    writeMqtt(QString("%1/event").arg(mqttTopicPrefix), "it100 module communications timeout");
-    writeMqtt(QString("%1/availability").arg(mqttTopicPrefix),"offline",QOS_1,true);
-    writeLog("Communications with IT100 has timed out", LOG_LEVEL_ERROR);
-    graylog->sendMessage("it100 module communications timeout", LevelNotice);
-
-    updateServiceStatus();
-}
-
-void It100Mqtt::onIt100ZoneStatusChange(int16_t zone, int16_t partition, it100::ZoneStatus status)
-{
-        switch (status) {
-            
-        case it100::ZONE_STATUS_ALARM:
-            if (!it100->isWaitingForStatusUpdate())
-                writeMqtt(QString("%1/zone/%2/event").arg(mqttTopicPrefix)
-                          .arg(zone),"alarm");
-            writeMqtt(QString("%1/zone/%2/condition").arg(mqttTopicPrefix)
-                      .arg(zone),"alarm",QOS_1,true);
-            graylog->sendMessage(QString("zone %1 is in alarm!").arg(zone), LevelCritical);
-            break;
-            
-        case it100::ZONE_STATUS_ALARM_RESTORED:
-            writeMqtt(QString("%1/zone/%2/event").arg(mqttTopicPrefix)
-                      .arg(zone),"alarm_restored");
-            writeMqtt(QString("alarm/event").arg(zone),"alarm_restored");
-            graylog->sendMessage(QString("zone %1 alarm restored!")
-                                 .arg(zone), LevelCritical);
-            break;
-            
-        case it100::ZONE_STATUS_OPEN:
-            if (!it100->isWaitingForStatusUpdate())
-                writeMqtt(QString("%1/zone/%2/event").arg(mqttTopicPrefix)
-                          .arg(zone),"violated");
-            writeMqtt(QString("%1/zone/%2/state").arg(mqttTopicPrefix)
-                      .arg(zone),"open",QOS_1,true);
-            writeMqtt(QString("%1/zone/%2/condition").arg(mqttTopicPrefix)
-                      .arg(zone),"violated",QOS_1,true);
-            graylog->sendMessage(QString("Zone %1 Open").arg(zone), LevelInformational);
-            break;
-            
-        case it100::ZONE_STATUS_RESTORED:
-            if (!it100->isWaitingForStatusUpdate())
-                writeMqtt(QString("%1/zone/%2/event").arg(mqttTopicPrefix)
-                          .arg(zone),"restored");
-            writeMqtt(QString("%1/zone/%2/state").arg(mqttTopicPrefix)
-                      .arg(zone),"closed",QOS_1,true);
-            writeMqtt(QString("%1/zone/%2/condition").arg(mqttTopicPrefix)
-                      .arg(zone),"secure",QOS_1,true);
-            graylog->sendMessage(QString("Zone %1 Restored").arg(zone), LevelInformational);
-            break;
-            
-        case it100::ZONE_STATUS_TAMPER:
-            if (!it100->isWaitingForStatusUpdate())
-                writeMqtt(QString("%1/zone/%2/event").arg(mqttTopicPrefix)
-                          .arg(zone),"tamper");
-            writeMqtt(QString("%1/zone/%2/condition").arg(mqttTopicPrefix)
-                      .arg(zone),"tamper",QOS_1,true);
-            graylog->sendMessage(QString("Zone %1 Tamper").arg(zone), LevelCritical);
-            break;
-            
-        case it100::ZONE_STATUS_TAMPER_RESTORED:
-            if (!it100->isWaitingForStatusUpdate())
-                writeMqtt(QString("%1/zone/%2/event").arg(mqttTopicPrefix)
-                          .arg(zone),"tamper_restored");
-                graylog->sendMessage(QString("Zone %1 Tamper Restored")
-                                     .arg(zone), LevelNotice);
-            break;
-            
-        case it100::ZONE_STATUS_FAULT:
-            if (!it100->isWaitingForStatusUpdate())
-                writeMqtt(QString("%1/zone/%1/event").arg(mqttTopicPrefix)
-                          .arg(zone),"fault",QOS_1,true);
-            writeMqtt(QString("%1/zone/%1/condition").arg(mqttTopicPrefix)
-                      .arg(zone),"fault",QOS_1,true);
-            graylog->sendMessage(QString("Zone %1 Fault").arg(zone), LevelCritical);
-            break;
-            
-        case it100::ZONE_STATUS_FAULT_RESTORED:
-            if (!it100->isWaitingForStatusUpdate())
-                writeMqtt(QString("%1/zone/%2/event").arg(mqttTopicPrefix)
-                          .arg(zone),"fault_restored");
-            // how do we determine the condition of the zone now?? does it100 send a restored/violated?
-            graylog->sendMessage(QString("Zone %1 Fault Restored")
-                                 .arg(zone), LevelNotice);
-            break;
-
-//            static const QByteArray CMD_LCD_UPDATE;
-//            static const QByteArray CMD_LCD_CURSOR;
-//            static const QByteArray CMD_LED_STATUS;
-//            static const QByteArray CMD_BEEP_STATUS;
-//            static const QByteArray CMD_TONE_STATUS;
-//            static const QByteArray CMD_BUZZER_STATUS;
-//            static const QByteArray CMD_DOOR_CHIME_STATUS;
-
-        default:
-            break;
-        }
-
-        writeLog(QString("ZoneStatusChange(partition=%1,zone=%2,status=%3)")
-                 .arg(partition).arg(zone).arg((qint8)status), LOG_LEVEL_DEBUG);
-}
-
-void It100Mqtt::processIt100UserEvent(it100::UserEventType type,
-                               int16_t partition, int16_t user)
-{
-    QString userLabel = nameFromUserCodeSlot(user);
-
-    if (type == it100::UserOpening) {
-        writeMqtt(QString("%1/partition/%2/user_disarmed")
-            .arg(mqttTopicPrefix).arg(partition),QString("%1:%2")
-                  .arg(user).arg(userLabel),QOS_1);
-    } else if (type == it100::UserClosing) {
-        writeMqtt(QString("%1/partition/%2/user_armed")
-            .arg(mqttTopicPrefix).arg(partition),QString("%1:%2")
-                  .arg(user).arg(userLabel),QOS_1);
-    }
-
-    // produce json string of event
-    QString userStr;
-    if (user >= 0) userStr = QString(", \"user\":%1, \"label\":\"%2\"")
-            .arg(user).arg(userLabel);
-    QString eventJson = QString("{ \"type\":\"%1\", \"partition\":%2%3 }")
-            .arg(it100::IT100::userEventTypeToString(type))
-            .arg(partition).arg(userStr);
-
-    writeMqtt(QString("%1/partition/%2/user_event")
-            .arg(mqttTopicPrefix).arg(partition),eventJson, QOS_1);
-
-    writeLog(QString("UserEvent: type=%1; partition=%2, user=%3, label=%4")
-            .arg(it100::IT100::userEventTypeToString(type))
-            .arg(partition).arg(user).arg(userLabel), LOG_LEVEL_NOTICE);
-}
-
-void It100Mqtt::onIt100PartitionArmedDescriptive(int16_t partition,
-                                                 it100::PartitionArmedMode mode)
-{
-    QString armed_mode = "armed_away";  
-    QString hass_armed_mode = "armed_away";
-    if (mode == it100::PARTITION_ARMED_STAY || mode == it100::PARTITION_ARMED_STAY_NODELAY) {
-        armed_mode = "armed_stay";
-        hass_armed_mode = "armed_home";
-        qDebug() << "ARMED STAY!";
-    }
-        
-    if (!it100->isWaitingForStatusUpdate())
-        writeMqtt(QString("%1/partition/%2/event").arg(mqttTopicPrefix)
-                  .arg(partition),armed_mode);
-
-    writeMqtt(QString("%1/partition/%2/armed").arg(mqttTopicPrefix)
-              .arg(partition),"1",QOS_1,true);
-    writeMqtt(QString("%1/partition/%2/state").arg(mqttTopicPrefix)
-              .arg(partition),armed_mode,QOS_1,true);
-    writeMqtt(QString("%1/partition/%2/hass_state").arg(mqttTopicPrefix)
-              .arg(partition),hass_armed_mode,QOS_1,true);
-
-//    writeLog(QString("Alarm partition %1 armed").arg(partition), LOG_LEVEL_NOTICE);
-//    graylog->sendMessage(QString("Partition %1 Armed!").arg(partition), LevelInformational);
-    // panel.partition(partition)->armed = true;
-
-}
-
-void It100Mqtt::onIt100PartitionStatusChange(int16_t partition,
-                                             it100::PartitionStatus status)
-{
-    switch (status) {
-    case it100::PARTITION_STATUS_ALARM:
-        if (!it100->isWaitingForStatusUpdate())
-            writeMqtt(QString("%1/partition/%2/event").arg(mqttTopicPrefix)
-                      .arg(partition),"alarm");
-            writeLog(QString("Alarm partition %1 in ALARM")
-                     .arg(partition), LOG_LEVEL_NOTICE);
-            graylog->sendMessage(QString("Partition %1 is in Alarm!")
-                                 .arg(partition), LevelCritical);
-        writeMqtt(QString("%1/partition/%2/state").arg(mqttTopicPrefix)
-                  .arg(partition),"alarm",QOS_1,true);
-        writeMqtt(QString("%1/partition/%2/hass_state").arg(mqttTopicPrefix)
-                  .arg(partition),"triggered",QOS_1,true);
-        writeMqtt(QString("%1/partition/%2/condition").arg(mqttTopicPrefix)
-                  .arg(partition),"alarm",QOS_1,true);
-        break;
-
-    case it100::PARTITION_STATUS_DISARMED: // 655
-        // we do not have a partition condition -- that should come in another message
-        if (!it100->isWaitingForStatusUpdate())
-            writeMqtt(QString("%1/partition/%2/event").arg(mqttTopicPrefix)
-                      .arg(partition),"disarmed");
-            writeLog(QString("Alarm partition %1 disarmed")
-                     .arg(partition), LOG_LEVEL_NOTICE);
-            graylog->sendMessage(QString("Partition %1 Disarmed!")
-                                 .arg(partition), LevelInformational);
-        writeMqtt(QString("%1/partition/%2/hass_state").arg(mqttTopicPrefix)
-                  .arg(partition),"disarmed",QOS_1,true);
-        writeMqtt(QString("%1/partition/%2/armed").arg(mqttTopicPrefix)
-                  .arg(partition),"0",QOS_1,true);
-        writeMqtt(QString("%1/partition/%2/state").arg(mqttTopicPrefix)
-                  .arg(partition),"disarmed",QOS_1,true);
-        panel.partition(partition)->armed = false;
-        break;
-
-    case it100::PARTITION_STATUS_READY:
-        if (!it100->isWaitingForStatusUpdate())
-            writeMqtt(QString("%1/partition/%2/event").arg(mqttTopicPrefix)
-                      .arg(partition),"disarmed");
-            graylog->sendMessage(QString("Partition %1 is Ready")
-                                 .arg(partition), LevelInformational);
-        writeMqtt(QString("%1/partition/%2/armed").arg(mqttTopicPrefix)
-                  .arg(partition),"0",QOS_1,true);
-        writeMqtt(QString("%1/partition/%2/hass_state").arg(mqttTopicPrefix)
-                  .arg(partition),"disarmed",QOS_1,true);
-        writeMqtt(QString("%1/partition/%2/state").arg(mqttTopicPrefix)
-                  .arg(partition),"disarmed",QOS_1,true);
-        writeMqtt(QString("%1/partition/%2/condition").arg(mqttTopicPrefix)
-                  .arg(partition),"ready");
-        break;
-
-    case it100::PARTITION_STATUS_NOT_READY:
-        if (!it100->isWaitingForStatusUpdate())
-            writeMqtt(QString("%1/partition/%2/event").arg(mqttTopicPrefix)
-                      .arg(partition),"not_ready");
-            graylog->sendMessage(QString("Partition %1 NOT Ready")
-                                 .arg(partition), LevelInformational);
-        writeMqtt(QString("%1/partition/%2/armed").arg(mqttTopicPrefix)
-                  .arg(partition),"0",QOS_1,true);
-        writeMqtt(QString("%1/partition/%2/hass_state").arg(mqttTopicPrefix)
-                  .arg(partition),"disarmed",QOS_1,true);
-        writeMqtt(QString("%1/partition/%2/state").arg(mqttTopicPrefix)
-                  .arg(partition),"disarmed",QOS_1,true);
-        writeMqtt(QString("%1/partition/%2/condition").arg(mqttTopicPrefix)
-                  .arg(partition),"not_ready",QOS_1,true);
-        break;
-        
-    case it100::PARTITION_STATUS_BUSY:
-        if (!it100->isWaitingForStatusUpdate())
-            writeMqtt(QString("%1/partition/%2/event").arg(mqttTopicPrefix)
-                      .arg(partition),"busy");
-        writeMqtt(QString("%1/partition/%2/armed").arg(mqttTopicPrefix)
-                  .arg(partition),"0",QOS_1,true);
-        writeMqtt(QString("%1/partition/%2/hass_state").arg(mqttTopicPrefix)
-                  .arg(partition),"disarmed",QOS_1,true);
-        writeMqtt(QString("%1/partition/%2/state").arg(mqttTopicPrefix)
-                  .arg(partition),"busy",QOS_1,true);
-        writeMqtt(QString("%1/partition/%2/condition").arg(mqttTopicPrefix)
-                  .arg(partition),"busy",QOS_1,true);
-        break;
-
-    case it100::PARTITION_STATUS_READY_FORCE_ARM:
-        if (!it100->isWaitingForStatusUpdate())
-            writeMqtt(QString("%1/partition/%2/event").arg(mqttTopicPrefix)
-                      .arg(partition),"ready_force_arm");
-            graylog->sendMessage(QString("Partition %1 Ready to Force Arm")
-                                 .arg(partition), LevelInformational);
-        writeMqtt(QString("%1/partition/%2/armed").arg(mqttTopicPrefix)
-                  .arg(partition),"0",QOS_1,true);
-        writeMqtt(QString("%1/partition/%2/hass_state").arg(mqttTopicPrefix)
-                  .arg(partition),"disarmed",QOS_1,true);
-        writeMqtt(QString("%1/partition/%2/state").arg(mqttTopicPrefix)
-                  .arg(partition),"disarmed",QOS_1,true);
-        writeMqtt(QString("%1/partition/%2/condition").arg(mqttTopicPrefix)
-                  .arg(partition),"ready_force_arm",QOS_1,true);
-        break;
-
-    case it100::PARTITION_STATUS_EXIT_DELAY_IN_PROGRESS:
-        if (!it100->isWaitingForStatusUpdate())
-            writeMqtt(QString("%1/partition/%2/event").arg(mqttTopicPrefix)
-                      .arg(partition),"exit_delay");
-            graylog->sendMessage(QString("Partition %1 Exit Delay in Progress")
-                                 .arg(partition), LevelInformational);
-        writeMqtt(QString("%1/partition/%2/hass_state").arg(mqttTopicPrefix)
-                  .arg(partition),"arming",QOS_1,true);
-        writeMqtt(QString("%1/partition/%2/state").arg(mqttTopicPrefix)
-                  .arg(partition),"exit_delay",QOS_1,true);
-        writeMqtt(QString("%1/partition/%2/condition").arg(mqttTopicPrefix)
-                  .arg(partition),"exit_delay",QOS_1,true);
-        break;
-
-    case it100::PARTITION_STATUS_ENTRY_DELAY_IN_PROGRESS:
-        if (!it100->isWaitingForStatusUpdate())
-            writeMqtt(QString("%1/partition/%2/event").arg(mqttTopicPrefix)
-                      .arg(partition),"entry_delay");
-            graylog->sendMessage(QString("Partition %1 Entry Delay in Progress")
-                                 .arg(partition), LevelInformational);
-        writeMqtt(QString("%1/partition/%2/hass_state").arg(mqttTopicPrefix)
-                  .arg(partition),"pending",QOS_1,true);
-        writeMqtt(QString("%1/partition/%2/state").arg(mqttTopicPrefix)
-                  .arg(partition),"entry_delay",QOS_1,true);
-        writeMqtt(QString("%1/partition/%2/condition").arg(mqttTopicPrefix)
-                  .arg(partition),"entry_delay",QOS_1,true);
-        break;
-
-    // we need to break this out as a seperate EVENT as it tells us which user armed
-    
-//    case PARTITION_STATUS_USER_CLOSING:
-//        if (!it100->isWaitingForStatusUpdate())
-//            writeMqtt(QString("%1/partition/%2/event").arg(mqttTopicPrefix).arg(partition),"user_closing");
-//        writeMqtt(QString("%1/partition/%2/event").arg(mqttTopicPrefix).arg(partition),"user_closing");
-//        break;
-
-    case it100::PARTITION_STATUS_PARTIAL_CLOSING:
-        writeMqtt(QString("%1/partition/%2/event").arg(mqttTopicPrefix)
-                  .arg(partition),"partial_closing");
-        break;
-
-    case it100::PARTITION_STATUS_SPECIAL_CLOSING:
-        writeMqtt(QString("%1/partition/%2/event").arg(mqttTopicPrefix)
-                  .arg(partition),"special_closing");
-        break;
-
-    case it100::PARTITION_STATUS_INVALID_ACCESS_CODE:
-        writeMqtt(QString("%1/partition/%2/event").arg(mqttTopicPrefix)
-                  .arg(partition),"invalid_access_code");
-        writeLog(QString("Invalid access code on Partition %1")
-                 .arg(partition), LOG_LEVEL_ERROR);
-        graylog->sendMessage(QString("Partition %1 Invalid Access Code!")
-                             .arg(partition), LevelNotice);
-        break;
-
-    case it100::PARTITION_STATUS_FUNCTION_NOT_AVAILABLE:
-        writeMqtt(QString("%1/partition/%2/event").arg(mqttTopicPrefix)
-                  .arg(partition),"function_not_available");
-        writeLog(QString("Invalid access code on Partition %1")
-                 .arg(partition), LOG_LEVEL_ERROR);
-        break;
-
-    }
-    writeLog(QString("PartitionStatusChange(partition=%1,status=%2)")
-             .arg(partition).arg((quint8)status));
-}
-
-void It100Mqtt::onIt100TroubleEvent(it100::TroubleEvent event)
-{
-
-    /*
-        TODO: Implement the following checks:
-        TROUBLE_TLM_1,
-        TROUBLE_TLM_1_RESTORE,
-        TROUBLE_TLM_2,
-        TROUBLE_TLM_2_RESTORE,
-        TROUBLE_FTC,
-        TROUBLE_BUFFER_NEAR_FULL,
-        TROUBLE_WIRELESS_KEY_LOW_BATTERY,
-        TROUBLE_WIRELESS_KEY_LOW_BATTERY_RESTORE,
-        TROUBLE_HANDHELD_KEYPAD_LOW_BATTERY,
-        TROUBLE_HANDHELD_KEYPAD_LOW_BATTERY_RESTORE,
-        TROUBLE_HOME_AUTOMATION,
-        TROUBLE_HOME_AUTOMATION_RESTORE
-      */
-
-    switch (event) {
-
-    case it100::TROUBLE_PANEL_BATTERY:
-        graylog->sendMessage("Trouble: Panel Battery", LevelError);
-        writeMqtt(QString("%1/event").arg(mqttTopicPrefix),"trouble_panel_battery");
-        break;
-
-    case it100::TROUBLE_PANEL_BATTERY_RESTORE:
-        graylog->sendMessage("Trouble: Panel Battery Restore", LevelNotice);
-        writeMqtt(QString("%1/event").arg(mqttTopicPrefix),"trouble_panel_battery_restore");
-        break;
-
-    case it100::TROUBLE_PANEL_AC:
-        graylog->sendMessage("Trouble: Panel AC", LevelError);
-        writeMqtt(QString("%1/event").arg(mqttTopicPrefix),"trouble_panel_ac");
-        break;
-
-    case it100::TROUBLE_PANEL_AC_RESTORE:
-        graylog->sendMessage("Trouble: Panel AC Restored", LevelNotice);
-        writeMqtt(QString("%1/event").arg(mqttTopicPrefix),"trouble_panel_ac_restore");
-        break;
-
-    case it100::TROUBLE_SYSTEM_BELL:
-        graylog->sendMessage("Trouble: System Bell", LevelCritical);
-        writeMqtt(QString("%1/event").arg(mqttTopicPrefix),"trouble_panel_bell");
-        break;
-
-    case it100::TROUBLE_SYSTEM_BELL_RESTORE:
-        graylog->sendMessage("Trouble: System Bell Restore", LevelNotice);
-        writeMqtt(QString("%1/event").arg(mqttTopicPrefix),"trouble_panel_bell_restore");
-        break;
-
-    case it100::TROUBLE_GENERAL_SYSTEM_TAMPER:
-        graylog->sendMessage("Trouble: General System Tamper", LevelCritical);
-        writeMqtt(QString("%1/event").arg(mqttTopicPrefix),"trouble_general_tamper");
-        break;
-
-    case it100::TROUBLE_GENERAL_SYSTEM_TAMPER_RESTORE:
-        graylog->sendMessage("Trouble: General System Tamper Restore", LevelNotice);
-        writeMqtt(QString("%1/event").arg(mqttTopicPrefix),"trouble_general_tamper_restore");
-        break;
-
-    case it100::TROUBLE_GENERAL_DEVICE_LOW_BATTERY:
-        graylog->sendMessage("Trouble: General Device Low Battery", LevelError);
-        writeMqtt(QString("%1/event").arg(mqttTopicPrefix),"trouble_general_device_low_battery");
-        break;
-
-    case it100::TROUBLE_GENERAL_DEVICE_LOW_BATTERY_RESTORE:
-        graylog->sendMessage("Trouble: General Device Low Battery Restore", LevelNotice);
-        writeMqtt(QString("%1/event").arg(mqttTopicPrefix),"trouble_general_device_low_battery_restore");
-        break;
-
-    default:
-        break;
-
-    }
-}
 
 // Write log entry to MQTT broker
 //
 void It100Mqtt::writeLog(QString msg, LogLevel level)
 {
-    writeLog(msg.toStdString().c_str(), level);
+    writeLog(mqttClientName, msg, level);
 }
 
 void It100Mqtt::writeLog(const char *msg, LogLevel level)
+{
+    writeLog(mqttClientName, QString(msg), level);
+}
+
+void It100Mqtt::writeLog(QString source, QString msg, LogLevel level)
 {
 
     // Determine topic level for log level
@@ -800,6 +499,6 @@ void It100Mqtt::writeLog(const char *msg, LogLevel level)
     }
 
     // Build and publish MQTT message
-    QMQTT::Message ttMsg(mId++,QString("log/%1/%2").arg(mqttClientName).arg(logLevel),QByteArray(msg));
-    client->publish(ttMsg);
+    writeMqtt(PublishTopic(QString("log/%1/%2").arg(source).arg(logLevel)),
+              msg.toUtf8());
 }
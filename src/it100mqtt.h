@@ -15,7 +15,12 @@
 
 #include "graylog.h"
 #include "it100.h"
-#include "alarmpanel.h"
+#include "it100serialtransport.h"
+#include "panelbridge.h"
+#include "retainedcache.h"
+#include "topictable.h"
+#include "allocationcounter.h"
+#include "publishspool.h"
 #include <qmqtt/qmqtt.h>
 
 #include <QCoreApplication>
@@ -24,21 +29,9 @@
 
 #include <QObject>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QSettings>
-#include <QMap>
-
-enum LogLevel {
-    LOG_LEVEL_ERROR,
-    LOG_LEVEL_SECURITY,
-    LOG_LEVEL_NOTICE,
-    LOG_LEVEL_DEBUG
-};
-
-enum QosLevel {
-    QOS_0 = 0,
-    QOS_1 = 1,
-    QOS_2 = 2
-};
+#include <QList>
 
 class It100Mqtt : public QObject
 {
@@ -46,22 +39,35 @@ class It100Mqtt : public QObject
 public:
     explicit It100Mqtt(QString settingsFile, QObject *parent = 0);
 
-    int connectToIt100(QHostAddress host, qint16 port = 4001);
+    int connectToIt100();
     int connectToMqttBroker(QHostAddress host, qint16 port = 1883);
 
     void writeLog(QString msg, LogLevel level = LOG_LEVEL_DEBUG);
     void writeLog(const char *msg, LogLevel level = LOG_LEVEL_DEBUG);
-    void writeMqtt(const char *topic, const char *message, QosLevel qos = QOS_0, bool retain = false);
-    void writeMqtt(const char *topic, QString message, QosLevel qos = QOS_0, bool retain = false);
-    void writeMqtt(QString topic, const char *message, QosLevel qos = QOS_0, bool retain = false);
-    void writeMqtt(QString topic, QString message, QosLevel qos = QOS_0, bool retain = false);
+    void writeLog(QString source, QString msg, LogLevel level);
+
+    // publish; retained values the broker already holds are dropped
+    bool writeMqtt(const PublishTopic &topic, QByteArray payload, QosLevel qos = QOS_0, bool retain = false);
+    bool writeMqtt(const char *topic, const char *message, QosLevel qos = QOS_0, bool retain = false);
 
-    QMQTT::Client *client;
+    struct PublishStats {
+        uint64_t publishes = 0;
+        uint64_t allocations = 0;   // only counted with CONFIG += count_allocations
+    };
+
+    const RetainedCache::Stats &retainedCacheStats() const { return retainedCache.stats(); }
+    const PublishStats &publishStatistics() const { return publishStats; }
+    const PublishSpool &publishSpool() const { return spool; }
+
+    QMQTT::Client *client = nullptr;
+    QMQTT::Router *router = nullptr;   // command topics, owned by client
     QString mqttClientName;
     QString mqttTopicPrefix; // idac/module/[mqttClientName]/
 
-    it100::IT100 *it100 = nullptr;
-    
+    Graylog *graylog;
+
+    QList<PanelBridge*> panels;
+
     bool failed() { return _failed; }
 
     // state of service
@@ -72,55 +78,52 @@ public:
 
 private:
 
-    QString nameFromUserCodeSlot(int32_t user);
-    bool loadUserSlots();
-
     bool _failed = false;
 
-    AlarmPanel panel;
-
-    Graylog *graylog;
-
     QTimer *testTimer;
-//    QSettings *settings;
+    QTimer *statsTimer = nullptr;
 
-    quint16 mId;
+    ConnectionSupervisor *mqttSupervisor = nullptr;
+//    QSettings *settings;
 
     // Settings
     bool debugMode;
-    QHostAddress it100RemoteHost;
-    quint16 it100RemotePort;
-    QString it100UserCode;
     QHostAddress m_mqttRemoteHost;
     quint16 m_mqttRemotePort;
+    bool mqttLatencyMode;
+    SocketTuning socketTuning;
 
-    QMap<int,QString> userSlots;
     QString configFile;
 
     ComponentStatus mqttStatus = COMP_STATUS_UNKNOWN;
 
+    RetainedCache retainedCache;
+    PublishStats publishStats;
+
+    PublishSpool spool;
+    uint64_t spoolDroppedReported = 0;
+    QElapsedTimer spoolStatusTimer;
+
+    void publish(const PublishTopic &topic, QByteArray payload, QosLevel qos, bool retain);
+    void reportPublishStats();
+    void reportStats();
+    void replaySpool();
+    int drainSpool();
+    void updateSpoolStatus();
+
 signals:
 
 public slots:
 
-    void onMqttConnect();
+    void onMqttConnack(quint8 ack);
     void onMqttDisconnected();
-    void reconnectTimerTimeout();
+    void onMqttError(QAbstractSocket::SocketError error);
+    void onMqttPubacked(quint8 type, quint16 msgid);
+    void onMqttSocketConnected(qintptr descriptor);
+    void onReconnected(QString name, qint64 downMsecs, QString histogram);
 
-    void onMqttMessageReceived(QMQTT::Message);
     void onTestTimerTimeout();
 
-    void onIt100Connected();
-    void onIt100Disconnected();
-    void onIt100ZoneStatusChange(int16_t zone, int16_t partition, it100::ZoneStatus status);
-    void processIt100UserEvent(it100::UserEventType type, int16_t partition, int16_t user);
-    void onIt100PartitionStatusChange(int16_t partition, it100::PartitionStatus status);
-    void onIt100PartitionArmedDescriptive(int16_t partition, it100::PartitionArmedMode mode);
-    void onIt100TroubleEvent(it100::TroubleEvent event);
-    void onIt100VirtualKeypadDisplayUpdate();
-    void onIt100CommunicationsBegin();
-    void onIt100CommunicationsTimeout();
-
 };
 
 #endif // IT100MQTT_H
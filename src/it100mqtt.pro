@@ -11,6 +11,9 @@ TEMPLATE = app
 
 unix: DEFINES += USE_SYSTEMD
 
+# qmake CONFIG+=count_allocations counts heap allocations per publish
+count_allocations: DEFINES += COUNT_ALLOCATIONS
+
 DEFINES += QMQTT_LIBRARY
 include(qmqtt/qmqtt.pri)
 
@@ -19,7 +22,20 @@ LIBS += -lsystemd
 SOURCES += main.cpp \
     it100.cpp \
     it100mqtt.cpp \
+    panelbridge.cpp \
     it100message.cpp \
+    it100commandqueue.cpp \
+    it100pacer.cpp \
+    it100linkhandoff.cpp \
+    connectionsupervisor.cpp \
+    retainedcache.cpp \
+    publishspool.cpp \
+    allocationcounter.cpp \
+    topictable.cpp \
+    sockettuning.cpp \
+    it100transport.cpp \
+    it100serialtransport.cpp \
+    it100framer.cpp \
     graylog.cpp \
     alarmpanel.cpp
 
@@ -27,7 +43,22 @@ HEADERS += \
     it100.h \
     it100commands.h \
     it100mqtt.h \
+    panelbridge.h \
     it100message.h \
+    it100commandqueue.h \
+    it100pacer.h \
+    it100spscring.h \
+    it100linkhandoff.h \
+    connectionsupervisor.h \
+    retainedcache.h \
+    publishspool.h \
+    allocationcounter.h \
+    topictable.h \
+    sockettuning.h \
+    it100transport.h \
+    it100serialtransport.h \
+    it100framer.h \
+    it100event.h \
     graylog.h \
     alarmpanel.h \
     commonservice.h
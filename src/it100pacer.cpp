@@ -0,0 +1,69 @@
+#include "it100pacer.h"
+
+namespace it100 {
+
+void TransmitPacer::setBaudRate(int baud)
+{
+    if (baud <= 0) baud = defaultBaudRate;
+    _baud = baud;
+    _bytesPerMsec = static_cast<double>(baud) / bitsPerByte / 1000.0;
+}
+
+void TransmitPacer::refill(int64_t now)
+{
+    if (now > _lastRefill) {
+        _tokens += (now - _lastRefill) * _bytesPerMsec;
+        if (_tokens > _burst) _tokens = _burst;
+    }
+    _lastRefill = now;
+}
+
+bool TransmitPacer::tryConsume(int bytes, int64_t now, int *delayMsecs)
+{
+    refill(now);
+
+    if (_tokens < bytes) {
+        if (!_waiting) {
+            _waiting = true;
+            _waitingSince = now;
+        }
+        // round up so the timer does not fire a moment early
+        *delayMsecs = static_cast<int>((bytes - _tokens) / _bytesPerMsec) + 1;
+        return false;
+    }
+
+    if (_waiting) {
+        int waited = static_cast<int>(now - _waitingSince);
+        _waiting = false;
+        _stats.waits++;
+        _stats.waitMsecs += waited;
+        if (waited > _stats.waitMaxMsecs) _stats.waitMaxMsecs = waited;
+    }
+
+    consume(bytes, now);
+    return true;
+}
+
+void TransmitPacer::consume(int bytes, int64_t now)
+{
+    refill(now);
+    _tokens -= bytes;
+    _stats.bytesSent += bytes;
+    _utilizationBytes += bytes;
+}
+
+double TransmitPacer::utilization(int64_t now) const
+{
+    int64_t elapsed = now - _utilizationSince;
+    if (elapsed <= 0) return 0;
+    double busy = _utilizationBytes / _bytesPerMsec;
+    return busy < elapsed ? busy / elapsed : 1.0;
+}
+
+void TransmitPacer::resetUtilization(int64_t now)
+{
+    _utilizationSince = now;
+    _utilizationBytes = 0;
+}
+
+} // namespace it100
@@ -0,0 +1,71 @@
+#ifndef IT100PACER_H
+#define IT100PACER_H
+
+#include <cstdint>
+
+namespace it100 {
+
+/**
+  * TransmitPacer
+  * Token bucket modelling the serial line to the IT-100
+  * Bytes refill at the line rate, so writes never run ahead of what
+  * the module can receive however fast the TCP side would take them
+  */
+class TransmitPacer
+{
+public:
+
+    static const int defaultBaudRate = 9600;
+    static const int bitsPerByte = 10; // 8N1: start + 8 data + stop
+
+    struct Stats {
+        uint64_t bytesSent = 0;
+        uint64_t waits = 0;         // writes held back for the bucket
+        int64_t waitMsecs = 0;      // total time held back
+        int waitMaxMsecs = 0;
+    };
+
+    TransmitPacer() { setBaudRate(defaultBaudRate); }
+
+    void setBaudRate(int baud);
+    int baudRate() const { return _baud; }
+
+    // the most the line may run ahead of its rate
+    void setBurstBytes(int bytes) { _burst = bytes; }
+
+    // true if bytes may be written now, and takes them from the bucket;
+    // otherwise delayMsecs is how long until they can be
+    bool tryConsume(int bytes, int64_t now, int *delayMsecs);
+
+    // take bytes that must be written regardless (retransmits); the
+    // bucket goes into debt and later writes wait
+    void consume(int bytes, int64_t now);
+
+    // fraction of line time in use since the last reset
+    double utilization(int64_t now) const;
+    void resetUtilization(int64_t now);
+
+    const Stats &stats() const { return _stats; }
+
+private:
+
+    void refill(int64_t now);
+
+    int _baud = 0;
+    double _bytesPerMsec = 0;
+    double _tokens = 0;
+    int _burst = 64;
+    int64_t _lastRefill = 0;
+
+    bool _waiting = false;
+    int64_t _waitingSince = 0;
+
+    int64_t _utilizationSince = 0;
+    uint64_t _utilizationBytes = 0;
+
+    Stats _stats;
+};
+
+} // namespace it100
+
+#endif // IT100PACER_H
@@ -0,0 +1,293 @@
+#include "it100serialtransport.h"
+
+#include <QDebug>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#ifdef __linux__
+#include <linux/serial.h>
+#endif
+
+namespace it100 {
+
+static speed_t baudToSpeed(int baud)
+{
+    switch (baud) {
+    case 1200: return B1200;
+    case 2400: return B2400;
+    case 4800: return B4800;
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    default: return B0;
+    }
+}
+
+// ##############
+// File descriptor
+// ##############
+
+TtyTransport::~TtyTransport()
+{
+    close();
+}
+
+void TtyTransport::attach(int fd)
+{
+    this->fd = fd;
+
+    readNotifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(readNotifier, &QSocketNotifier::activated,
+            this, &Transport::readyRead);
+
+    writeNotifier = new QSocketNotifier(fd, QSocketNotifier::Write, this);
+    writeNotifier->setEnabled(false);
+    connect(writeNotifier, &QSocketNotifier::activated,
+            this, &TtyTransport::writePending);
+
+    _errorString.clear();
+    emit connected();
+}
+
+void TtyTransport::close()
+{
+    if (readNotifier) {
+        readNotifier->setEnabled(false);
+        readNotifier->deleteLater();
+        readNotifier = nullptr;
+    }
+    if (writeNotifier) {
+        writeNotifier->setEnabled(false);
+        writeNotifier->deleteLater();
+        writeNotifier = nullptr;
+    }
+    pending.clear();
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+int64_t TtyTransport::read(char *data, int64_t maxSize)
+{
+    if (fd < 0) return -1;
+
+    ssize_t n = ::read(fd, data, static_cast<size_t>(maxSize));
+    if (n > 0) return n;
+    if (n < 0 && (errno == EAGAIN || errno == EINTR)) return 0;
+
+    // 0 on a tty with VMIN 1 means hangup, eg. the pty master closed
+    fail(n == 0 ? QString("hangup") : QString(strerror(errno)));
+    return -1;
+}
+
+int64_t TtyTransport::write(const char *data, int64_t size)
+{
+    if (fd < 0) return -1;
+
+    // keep the order; the notifier writes this lot after what is held
+    if (!pending.isEmpty()) {
+        pending.append(data, static_cast<int>(size));
+        return size;
+    }
+
+    int64_t written = 0;
+    while (written < size) {
+        ssize_t n = ::write(fd, data + written, static_cast<size_t>(size - written));
+        if (n > 0) {
+            written += n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && errno == EAGAIN) {
+            // output buffer full; hold the rest until the driver drains
+            pending.append(data + written, static_cast<int>(size - written));
+            writeNotifier->setEnabled(true);
+            return size;
+        } else {
+            fail(QString(strerror(errno)));
+            return -1;
+        }
+    }
+    return written;
+}
+
+void TtyTransport::writePending()
+{
+    while (fd >= 0 && !pending.isEmpty()) {
+        ssize_t n = ::write(fd, pending.constData(), static_cast<size_t>(pending.size()));
+        if (n > 0) {
+            pending.remove(0, static_cast<int>(n));
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && errno == EAGAIN) {
+            return;
+        } else {
+            fail(QString(strerror(errno)));
+            return;
+        }
+    }
+    if (writeNotifier) writeNotifier->setEnabled(false);
+}
+
+void TtyTransport::fail(const QString &what)
+{
+    close();
+    _errorString = what;
+    QMetaObject::invokeMethod(this, "disconnected", Qt::QueuedConnection);
+}
+
+// ###########
+// Serial port
+// ###########
+
+SerialTransport::SerialTransport(QString device, int baud, QObject *parent) :
+    TtyTransport(parent)
+{
+    this->device = device;
+    this->baud = baud;
+}
+
+/**
+  * open()
+  * Raw mode: no echo, no line discipline, no CR/LF translation
+  * VMIN 1 / VTIME 0 so a read returns as soon as one byte is in;
+  * reads are non-blocking and driven by the notifier in any case
+  */
+void SerialTransport::open()
+{
+    close();
+
+    speed_t speed = baudToSpeed(baud);
+    if (speed == B0) {
+        fail(QString("unsupported baud rate %1").arg(baud));
+        return;
+    }
+
+    int fd = ::open(device.toLocal8Bit().constData(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        fail(QString(strerror(errno)));
+        return;
+    }
+
+    struct termios tio;
+    if (tcgetattr(fd, &tio) < 0) {
+        int error = errno;
+        ::close(fd);
+        fail(QString(strerror(error)));
+        return;
+    }
+
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+    tio.c_iflag &= ~(IXON | IXOFF | IXANY);
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+
+    if (tcsetattr(fd, TCSANOW, &tio) < 0) {
+        int error = errno;
+        ::close(fd);
+        fail(QString(strerror(error)));
+        return;
+    }
+
+#ifdef __linux__
+    // hand bytes up without the driver's batching delay; not all
+    // drivers (or ptys) support it, which is fine
+    struct serial_struct serial;
+    if (ioctl(fd, TIOCGSERIAL, &serial) == 0) {
+        serial.flags |= ASYNC_LOW_LATENCY;
+        ioctl(fd, TIOCSSERIAL, &serial);
+    }
+#endif
+
+    // discard whatever arrived before we were listening
+    tcflush(fd, TCIOFLUSH);
+
+    attach(fd);
+}
+
+// ##############
+// Pseudo terminal
+// ##############
+
+// made up front so name() has the slave for log messages
+PtyTransport::PtyTransport(QObject *parent) : TtyTransport(parent)
+{
+    create();
+}
+
+PtyTransport::~PtyTransport()
+{
+    close();
+    if (heldSlave >= 0) ::close(heldSlave);
+    if (master >= 0) ::close(master);
+}
+
+/**
+  * create()
+  * The slave is held open here as well, so the link stays up while
+  * the other end attaches and detaches
+  */
+bool PtyTransport::create()
+{
+    int fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0 || grantpt(fd) < 0 || unlockpt(fd) < 0) {
+        int error = errno;
+        if (fd >= 0) ::close(fd);
+        errno = error;
+        return false;
+    }
+
+    master = fd;
+    slave = QString::fromLocal8Bit(ptsname(fd));
+
+    // raw line discipline, as a real serial port would be
+    heldSlave = ::open(slave.toLocal8Bit().constData(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (heldSlave >= 0) {
+        struct termios tio;
+        if (tcgetattr(heldSlave, &tio) == 0) {
+            cfmakeraw(&tio);
+            tcsetattr(heldSlave, TCSANOW, &tio);
+        }
+    }
+
+    qWarning() << qPrintable(QString("it100 pty: attach the panel simulator to %1")
+                             .arg(slave));
+    return true;
+}
+
+/**
+  * open()
+  * Attach a duplicate of the master; close() and fail() close only
+  * the duplicate, so the pty and its slave name outlive them
+  */
+void PtyTransport::open()
+{
+    close();
+
+    if (master < 0 && !create()) {
+        fail(QString(strerror(errno)));
+        return;
+    }
+
+    int fd = fcntl(master, F_DUPFD_CLOEXEC, 0);
+    if (fd < 0) {
+        fail(QString(strerror(errno)));
+        return;
+    }
+
+    attach(fd);
+}
+
+} // namespace it100
@@ -0,0 +1,103 @@
+#ifndef IT100SERIALTRANSPORT_H
+#define IT100SERIALTRANSPORT_H
+
+#include <QSocketNotifier>
+
+#include "it100transport.h"
+
+namespace it100 {
+
+/**
+  * TtyTransport
+  * Non-blocking file descriptor read from a QSocketNotifier, so
+  * bytes reach the framer as soon as the driver has them. What the
+  * driver will not take yet is held and written as it drains
+  */
+class TtyTransport : public Transport
+{
+    Q_OBJECT
+public:
+    explicit TtyTransport(QObject *parent = nullptr) : Transport(parent) {}
+    ~TtyTransport();
+
+    void close() override;
+    bool isOpen() const override { return fd >= 0; }
+    int64_t read(char *data, int64_t maxSize) override;
+    int64_t write(const char *data, int64_t size) override;
+
+protected:
+
+    // take over an open descriptor and report the link up
+    void attach(int fd);
+
+    // record the error, close and report the link down; reported
+    // queued, as this may be called from inside the owner's write
+    void fail(const QString &what);
+
+    int fd = -1;
+
+private:
+
+    void writePending();
+
+    QSocketNotifier *readNotifier = nullptr;
+    QSocketNotifier *writeNotifier = nullptr;
+    QByteArray pending;
+
+};
+
+/**
+  * SerialTransport
+  * Direct RS-232 link to the IT-100 through termios
+  * Raw 8N1, no flow control. Any tty will do, including the slave
+  * side of a pty
+  */
+class SerialTransport : public TtyTransport
+{
+    Q_OBJECT
+public:
+    SerialTransport(QString device, int baud, QObject *parent = nullptr);
+
+    void open() override;
+    QString name() const override { return device; }
+
+private:
+
+    QString device;
+    int baud;
+
+};
+
+/**
+  * PtyTransport
+  * Master side of a pseudo terminal; a panel simulator (or socat,
+  * minicom) attaches to slaveName() as it would to a real serial
+  * port. The pty is made once and kept, so the slave name stays the
+  * same across reconnects and the simulator can stay attached
+  */
+class PtyTransport : public TtyTransport
+{
+    Q_OBJECT
+public:
+    explicit PtyTransport(QObject *parent = nullptr);
+    ~PtyTransport();
+
+    void open() override;
+    QString name() const override { return QString("pty %1").arg(slave); }
+
+    QString slaveName() const { return slave; }
+
+private:
+
+    // false, with errno set, if no pty could be had
+    bool create();
+
+    QString slave;
+    int master = -1;
+    int heldSlave = -1;
+
+};
+
+} // namespace it100
+
+#endif // IT100SERIALTRANSPORT_H
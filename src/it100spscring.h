@@ -0,0 +1,66 @@
+#ifndef IT100SPSCRING_H
+#define IT100SPSCRING_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace it100 {
+
+/**
+  * SpscRing
+  * Bounded queue for exactly one producer thread and one consumer
+  * thread, without locks. Items are copied in and out, so keep them
+  * plain data. Capacity must be a power of two
+  */
+template <typename T, int Capacity>
+class SpscRing
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscRing capacity must be a power of two");
+
+public:
+
+    static constexpr int capacity() { return Capacity; }
+
+    // producer; false if the ring is full
+    bool push(const T &item)
+    {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) == Capacity) return false;
+        slots[head & mask] = item;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer; false if the ring is empty
+    bool pop(T *item)
+    {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) return false;
+        *item = slots[tail & mask];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // exact from either end, a snapshot from anywhere else
+    int size() const
+    {
+        return static_cast<int>(_head.load(std::memory_order_acquire) -
+                                _tail.load(std::memory_order_acquire));
+    }
+
+private:
+
+    static const uint32_t mask = Capacity - 1;
+
+    // each index on its own cache line so the two threads do not
+    // contend for it
+    alignas(64) std::atomic<uint32_t> _head { 0 };
+    alignas(64) std::atomic<uint32_t> _tail { 0 };
+    T slots[Capacity];
+
+};
+
+} // namespace it100
+
+#endif // IT100SPSCRING_H
@@ -0,0 +1,180 @@
+#include "it100transport.h"
+
+#include <QDebug>
+#include <QTimer>
+
+#include <cstring>
+
+#include "it100commands.h"
+
+namespace it100 {
+
+// ###########
+// TCP/IP link
+// ###########
+
+TcpTransport::TcpTransport(QHostAddress host, uint16_t port, QObject *parent) :
+    Transport(parent)
+{
+    this->host = host;
+    this->port = port;
+
+    socket = new QTcpSocket(this);
+    connect(socket, &QTcpSocket::readyRead,
+            this, &Transport::readyRead);
+    connect(socket, &QTcpSocket::stateChanged,
+            this, &TcpTransport::processStateChange);
+}
+
+void TcpTransport::open()
+{
+    if (host.isNull() || port == 0) {
+        _errorString = QString("no host configured");
+        emit disconnected();
+        return;
+    }
+    socket->connectToHost(host, port);
+}
+
+void TcpTransport::close()
+{
+    socket->abort();
+}
+
+bool TcpTransport::isOpen() const
+{
+    return socket->state() == QAbstractSocket::ConnectedState;
+}
+
+int64_t TcpTransport::read(char *data, int64_t maxSize)
+{
+    int64_t n = socket->read(data, maxSize);
+    if (n > 0 && tuned && tuning.quickAck)
+        SocketTuning::rearmQuickAck(socket->socketDescriptor());
+    return n;
+}
+
+int64_t TcpTransport::write(const char *data, int64_t size)
+{
+    return socket->write(data, size);
+}
+
+QString TcpTransport::name() const
+{
+    return QString("%1 tcp/%2")
+        .arg(host.toString())
+        .arg(QString::number(port));
+}
+
+void TcpTransport::setTuning(const SocketTuning &tuning)
+{
+    this->tuning = tuning;
+    tuned = true;
+}
+
+void TcpTransport::processStateChange(QAbstractSocket::SocketState state)
+{
+    switch (state) {
+    case QAbstractSocket::ConnectedState:
+        if (tuned) {
+            QStringList failed = tuning.apply(socket->socketDescriptor());
+            if (!failed.isEmpty())
+                qDebug() << qPrintable(QString("%1: could not set %2")
+                    .arg(name()).arg(failed.join(", ")));
+        }
+        emit connected();
+        break;
+
+    case QAbstractSocket::UnconnectedState:
+        _errorString = socket->errorString();
+        emit disconnected();
+        break;
+
+    default:
+        break;
+    }
+}
+
+// ##############
+// In-memory link
+// ##############
+
+LoopbackTransport::LoopbackTransport(QObject *parent) : Transport(parent)
+{
+}
+
+void LoopbackTransport::open()
+{
+    _open = true;
+    emit connected();
+}
+
+void LoopbackTransport::close()
+{
+    _open = false;
+    inbound.clear();
+    inboundPos = 0;
+}
+
+int64_t LoopbackTransport::read(char *data, int64_t maxSize)
+{
+    if (!_open) return -1;
+
+    int64_t n = qMin<int64_t>(maxSize, inbound.size() - inboundPos);
+    if (n <= 0) return 0;
+    memcpy(data, inbound.constData() + inboundPos, n);
+    inboundPos += n;
+
+    if (inboundPos == inbound.size()) {
+        inbound.clear();
+        inboundPos = 0;
+    }
+    return n;
+}
+
+int64_t LoopbackTransport::write(const char *data, int64_t size)
+{
+    if (!_open) return -1;
+
+    if (keepWritten) written.append(data, size);
+
+    // IT100 writes one whole command per call
+    if (autoAcknowledge && size >= 3) {
+        char ack[10] = { '5', '0', '0', data[0], data[1], data[2] };
+        writeChecksum(checksum(ack, 6), ack + 6);
+        ack[8] = '\r';
+        ack[9] = '\n';
+        feed(ack, sizeof(ack));
+    }
+    return size;
+}
+
+/**
+  * feed(data, size)
+  * readyRead() is announced from the event loop, never from inside a
+  * call into the transport, as a socket would
+  */
+void LoopbackTransport::feed(const char *data, int64_t size)
+{
+    bool announce = (inbound.size() == inboundPos);
+    inbound.append(data, size);
+    if (announce)
+        QTimer::singleShot(0, this, [this]() {
+            if (_open && inbound.size() > inboundPos) emit readyRead();
+        });
+}
+
+QByteArray LoopbackTransport::takeWritten()
+{
+    QByteArray data = written;
+    written.clear();
+    return data;
+}
+
+void LoopbackTransport::hangup()
+{
+    close();
+    emit disconnected();
+}
+
+} // namespace it100
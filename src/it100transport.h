@@ -0,0 +1,137 @@
+#ifndef IT100TRANSPORT_H
+#define IT100TRANSPORT_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHostAddress>
+#include <QTcpSocket>
+
+#include "sockettuning.h"
+
+namespace it100 {
+
+enum InterfaceType {
+    IFACE_RS232 = 0,
+    IFACE_IPSERIAL = 1,
+    IFACE_PTY = 2       // a panel simulator on the slave side
+};
+
+/**
+  * Transport
+  * Byte link between IT100 and the module; IT100 only sees this
+  * interface. open() may complete later; connected() or
+  * disconnected() says how it went
+  */
+class Transport : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Transport(QObject *parent = nullptr) : QObject(parent) {}
+
+    virtual void open() = 0;
+    virtual void close() = 0;
+    virtual bool isOpen() const = 0;
+
+    // non-blocking; 0 when nothing is buffered, -1 on failure
+    virtual int64_t read(char *data, int64_t maxSize) = 0;
+    virtual int64_t write(const char *data, int64_t size) = 0;
+
+    // where the link goes, for log messages
+    virtual QString name() const = 0;
+
+    QString errorString() const { return _errorString; }
+
+signals:
+
+    void connected();
+
+    // emitted on loss of the link and on a failed open()
+    void disconnected();
+
+    void readyRead();
+
+protected:
+
+    QString _errorString;
+
+};
+
+/**
+  * TcpTransport
+  * IT-100 behind ser2net or a serial-IP adapter
+  */
+class TcpTransport : public Transport
+{
+    Q_OBJECT
+public:
+    TcpTransport(QHostAddress host, uint16_t port, QObject *parent = nullptr);
+
+    void open() override;
+    void close() override;
+    bool isOpen() const override;
+    int64_t read(char *data, int64_t maxSize) override;
+    int64_t write(const char *data, int64_t size) override;
+    QString name() const override;
+
+    // latency mode, applied on each connect
+    void setTuning(const SocketTuning &tuning);
+
+private:
+
+    void processStateChange(QAbstractSocket::SocketState state);
+
+    QTcpSocket *socket;
+    QHostAddress host;
+    uint16_t port;
+
+    bool tuned = false;
+    SocketTuning tuning;
+
+};
+
+/**
+  * LoopbackTransport
+  * In-memory link for driving IT100 without a module
+  * feed() supplies received bytes; written bytes are kept for
+  * takeWritten(), and with auto acknowledge each written command
+  * is answered with its 500 so the command window keeps moving
+  */
+class LoopbackTransport : public Transport
+{
+    Q_OBJECT
+public:
+    explicit LoopbackTransport(QObject *parent = nullptr);
+
+    void open() override;
+    void close() override;
+    bool isOpen() const override { return _open; }
+    int64_t read(char *data, int64_t maxSize) override;
+    int64_t write(const char *data, int64_t size) override;
+    QString name() const override { return QString("loopback"); }
+
+    // queue bytes as if received from the module and announce them
+    void feed(const char *data, int64_t size);
+    void feed(const QByteArray &data) { feed(data.constData(), data.size()); }
+
+    void setAutoAcknowledge(bool value) { autoAcknowledge = value; }
+    void setKeepWritten(bool value) { keepWritten = value; }
+    QByteArray takeWritten();
+
+    // drop the link as a module would
+    void hangup();
+
+private:
+
+    bool _open = false;
+    bool autoAcknowledge = false;
+    bool keepWritten = true;
+
+    QByteArray inbound;
+    int inboundPos = 0;
+    QByteArray written;
+
+};
+
+} // namespace it100
+
+#endif // IT100TRANSPORT_H
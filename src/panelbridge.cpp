@@ -0,0 +1,824 @@
+#include "panelbridge.h"
+#include "it100mqtt.h"
+#include "it100commands.h"
+
+#include <QDebug>
+
+PanelBridge::PanelBridge(It100Mqtt *service, QString name, QString topicPrefix,
+                         QObject *parent) :
+    QObject(parent)
+{
+    this->service = service;
+    graylog = service->graylog;
+    panelName = name;
+    mqttTopicPrefix = topicPrefix;
+    topics.build(topicPrefix);
+}
+
+/**
+  * configure(settings, group, debugMode, tuning)
+  * Build the module and its transport from an [it100] style group;
+  * tuning is applied to a TCP link when not null
+  */
+bool PanelBridge::configure(QSettings &settings, QString group, bool debugMode,
+                            const SocketTuning *tuning)
+{
+    configFile = settings.fileName();
+
+    settings.beginGroup(group);
+    QString serialDevice = settings.value("device", QString()).toString();
+    QString interfaceName = settings.value("interface", "tcp").toString();
+    it100::InterfaceType interface = (interfaceName == "serial") ? it100::IFACE_RS232
+            : (interfaceName == "pty") ? it100::IFACE_PTY : it100::IFACE_IPSERIAL;
+    QHostAddress remoteHost = QHostAddress(settings.value("host", QString()).toString());
+    quint16 remotePort = settings.value("port", 0).toInt();
+    QString userCode = settings.value("user_code", QString()).toString();
+    int commandWindow = settings.value("command_window", 1).toInt();
+    int baudRate = settings.value("baud", 9600).toInt();
+    bool latencyMode = settings.value("latency_mode", false).toBool();
+    bool ioThread = settings.value("io_thread", true).toBool();
+    int ioCpu = settings.value("io_cpu", -1).toInt();
+    settings.endGroup();
+
+    if ((interface == it100::IFACE_IPSERIAL && remotePort == 0) ||
+            (interface == it100::IFACE_RS232 && serialDevice.isEmpty()))
+        return false;
+
+    // [it100-name] panels may keep their own [users-name]
+    usersGroup = "users";
+    if (group.startsWith("it100-") &&
+            settings.childGroups().contains(QString("users-%1").arg(panelName)))
+        usersGroup = QString("users-%1").arg(panelName);
+
+    // no parent; the handoff below takes it, and its thread with it
+    it100::IT100 *it100 = new it100::IT100(debugMode);
+    if (interface == it100::IFACE_RS232)
+        it100->setTransport(new it100::SerialTransport(serialDevice, baudRate));
+    else if (interface == it100::IFACE_PTY)
+        it100->setTransport(new it100::PtyTransport());
+    else {
+        it100::TcpTransport *tcp = new it100::TcpTransport(remoteHost, remotePort);
+        if (latencyMode && tuning) {
+            tcp->setTuning(*tuning);
+            qDebug() << qPrintable(QString("%1 latency mode: %2")
+                                   .arg(panelName).arg(tuning->describe()));
+        }
+        it100->setTransport(tcp);
+    }
+
+    it100->setUserCode(userCode.toInt());
+    it100->setCommandWindow(commandWindow);
+    it100->setLinkBaudRate(baudRate);
+
+    linkName = it100->linkName();
+
+    connect(it100, &it100::IT100::connected,
+            this, &PanelBridge::onIt100Connected);
+    connect(it100, &it100::IT100::disconnected,
+            this, &PanelBridge::onIt100Disconnected);
+    connect(it100, &it100::IT100::communicationsBegin,
+            this, &PanelBridge::onIt100CommunicationsBegin);
+    connect(it100, &it100::IT100::communicationsTimeout,
+            this, &PanelBridge::onIt100CommunicationsTimeout);
+    connect(it100, &it100::IT100::keySequenceComplete,
+            this, &PanelBridge::onIt100KeySequenceComplete);
+
+    // from here on the module is only reached through the handoff
+    link = new it100::LinkHandoff(it100, this, this);
+    link->setThreaded(ioThread, ioCpu);
+    connect(link, &it100::LinkHandoff::reconnected,
+            service, &It100Mqtt::onReconnected);
+    connect(link, &it100::LinkHandoff::keySequenceRejected,
+            this, &PanelBridge::onKeySequenceRejected);
+
+    // load from disk
+    loadUserSlots();
+
+    return true;
+}
+
+void PanelBridge::open()
+{
+    link->start();
+}
+
+void PanelBridge::route(QMQTT::Router *router)
+{
+    connect(router->subscribe(QString("%1/command").arg(mqttTopicPrefix), QOS_1),
+            &QMQTT::RouteSubscription::received, this, &PanelBridge::onCommandMessage);
+    connect(router->subscribe(QString("%1/keypad").arg(mqttTopicPrefix), QOS_1),
+            &QMQTT::RouteSubscription::received, this, &PanelBridge::onKeypadMessage);
+}
+
+/**
+  * reportStats()
+  * Handoff depth and latency, as measured on this thread, then the
+  * module counters as last copied out by the module thread
+  */
+void PanelBridge::reportStats()
+{
+    it100::LinkHandoff::Stats handoff = link->stats();
+    qDebug() << qPrintable(QString("%1 handoff: %2 events, %3 dropped, depth at most %4, "
+                                   "latency %5 us last, %6 us avg, %7 us max; "
+                                   "%8 commands, %9 dropped, depth at most %10, "
+                                   "latency %11 us max")
+                           .arg(panelName)
+                           .arg(handoff.events)
+                           .arg(handoff.eventDrops)
+                           .arg(handoff.eventDepthMax)
+                           .arg(handoff.eventLatencyLastUsecs)
+                           .arg(handoff.eventLatencyAvgUsecs)
+                           .arg(handoff.eventLatencyMaxUsecs)
+                           .arg(handoff.commands)
+                           .arg(handoff.commandDrops)
+                           .arg(handoff.commandDepthMax)
+                           .arg(handoff.commandLatencyMaxUsecs));
+
+    it100::LinkHandoff::ModuleStats module = link->moduleStats();
+    qDebug() << qPrintable(QString("%1 framer: %2 lines in %3 reads, at most %4 per read; "
+                                   "%5 overruns, %6 checksum rejects, %7 length rejects")
+                           .arg(panelName)
+                           .arg(module.framer.linesFramed)
+                           .arg(module.framer.reads)
+                           .arg(module.framer.linesPerReadMax)
+                           .arg(module.framer.overruns)
+                           .arg(module.checksumRejects)
+                           .arg(module.lengthRejects));
+
+    qDebug() << qPrintable(QString("%1 pacer: %2 bytes sent, %3% of the line; "
+                                   "%4 waits for tokens, %5 ms in all, %6 ms at most")
+                           .arg(panelName)
+                           .arg(module.pacer.bytesSent)
+                           .arg(module.linkUtilization * 100, 0, 'f', 1)
+                           .arg(module.pacer.waits)
+                           .arg(module.pacer.waitMsecs)
+                           .arg(module.pacer.waitMaxMsecs));
+
+    const it100::IT100::CommandLinkStats &commands = module.link;
+    qDebug() << qPrintable(QString("%1 commands: %2 sent, %3 acknowledged, %4 errors, "
+                                   "%5 retransmits, %6 abandoned, %7 unmatched acks; "
+                                   "rtt %8 ms last, %9 ms min, %10 ms avg, %11 ms max")
+                           .arg(panelName)
+                           .arg(commands.sent)
+                           .arg(commands.acknowledged)
+                           .arg(commands.errors)
+                           .arg(commands.retransmits)
+                           .arg(commands.abandoned)
+                           .arg(commands.unmatchedAcks)
+                           .arg(commands.rttLastMsecs)
+                           .arg(commands.rttMinMsecs)
+                           .arg(commands.rttAvgMsecs)
+                           .arg(commands.rttMaxMsecs));
+
+    for (int lane = 0; lane < it100::LANE_COUNT; lane++) {
+        const it100::CommandQueue::Stats &queue = module.lanes[lane];
+        if (!queue.enqueued && !queue.dropped) continue;
+        qDebug() << qPrintable(QString("%1 %2 lane: %3 queued, %4 dropped, %5 coalesced, "
+                                       "depth at most %6; queued %7 ms last, %8 ms avg, %9 ms max")
+                               .arg(panelName)
+                               .arg(it100::commandLaneName(it100::CommandLane(lane)))
+                               .arg(queue.enqueued)
+                               .arg(queue.dropped)
+                               .arg(queue.coalesced)
+                               .arg(queue.depthHighWater)
+                               .arg(queue.delayLastMsecs)
+                               .arg(queue.delayAvgMsecs)
+                               .arg(queue.delayMaxMsecs));
+    }
+}
+
+QString PanelBridge::nameFromUserCodeSlot(int32_t user)
+{
+    loadUserSlots();
+
+    if (!userSlots.contains(user)) return "unknown";
+
+    return userSlots.value(user);
+}
+
+bool PanelBridge::loadUserSlots()
+{
+    userSlots.clear();
+    QSettings settings(configFile,QSettings::IniFormat,this);
+    settings.beginGroup(usersGroup);
+    foreach ( auto key, settings.childKeys() ) {
+        // make sure we dont try to add anything without a key as this is likely
+        // a mistake
+        if (key.toInt() <= 0 || key.toInt() > 1000) continue;
+
+        userSlots.insert(key.toInt(),settings.value(key).toString());
+        qDebug() << "added" << key.toInt() << settings.value(key).toString();
+    }
+    settings.endGroup();
+    return true;
+}
+
+void PanelBridge::onIt100VirtualKeypadDisplayUpdate()
+{
+	// send as QOS 1 (QOS 2 not supported by RabbitMQ MQTT)
+	// Retained topic for late joining clients
+    writeMqtt(topics.system(TopicTable::SystemKeypadLcdData),
+              link->lcdDisplayContents(), QOS_1, true);
+}
+
+/**
+  * onKeypadMessage(routed)
+  * Keypad sequence, eg. "*8" + installer code, "F~" for a held fire key
+  * Not logged as it may carry access codes
+  */
+void PanelBridge::onKeypadMessage(const QMQTT::RoutedMessage &routed)
+{
+    const QMQTT::Message &message = routed.message();
+    if (!link->sendKeySequence(message.payload())) {
+        QString logMessage = QString("Keypad sequence not accepted (%1 keys)")
+                .arg(message.payload().size());
+        graylog->sendMessage(logMessage, LevelError);
+        writeLog(logMessage, LOG_LEVEL_ERROR);
+    }
+}
+
+/**
+  * onCommandMessage(routed)
+  * TOPIC_PREFIX/command: arm, disarm or a single keypress
+  */
+void PanelBridge::onCommandMessage(const QMQTT::RoutedMessage &routed)
+{
+    const QMQTT::Message &message = routed.message();
+    QString payload = QString(message.payload()).toLower();
+
+    QString logMessage = QString("Received MQTT Message: %1 %2 (id=%3;qos=%4)")
+            .arg(QString(message.topic()))
+            .arg(payload)
+            .arg(message.id())
+            .arg(message.qos());
+
+    graylog->sendMessage(logMessage, LevelDebug);
+    writeLog(logMessage);
+
+    if (payload == "arm" || payload == "arm_away") {
+        link->armAway();
+        writeLog("requested to arm", LOG_LEVEL_DEBUG);
+        graylog->sendMessage("Requested to ARM; Arming", LevelNotice);
+    }
+    else if (payload == "arm_stay") {
+        link->armStay();
+        writeLog("requested to arm stay", LOG_LEVEL_DEBUG);
+        graylog->sendMessage("Requested to ARM STAY; Arming", LevelNotice);
+    }
+    else if (payload == "disarm") {
+        link->disarm();
+        writeLog("requested to disarm", LOG_LEVEL_DEBUG);
+        graylog->sendMessage("Requested to DISARM, Disarming", LevelNotice);
+    }
+    else if (payload.length() == 1) {
+
+        // SINGLE CHARACTER -- KEYPRESS
+        // sent with its keybreak; see TOPIC_PREFIX/keypad for sequences
+        if (!link->sendKeySequence(message.payload()))
+            writeLog(QString("Keypress not sent: %1").arg(payload), LOG_LEVEL_ERROR);
+
+    }
+    //else if (message.payload().toInt()) { // is command alpha?
+    //}
+
+    else {
+        QString logMessage = QString("Command not understood: %1")
+                .arg(payload);
+        graylog->sendMessage(logMessage, LevelError);
+        writeLog(logMessage, LOG_LEVEL_ERROR);
+    }
+}
+
+void PanelBridge::writeMqtt(const PublishTopic &topic, QByteArray payload,
+                            QosLevel qos, bool retain)
+{
+    // hold state back until the whole snapshot is in
+    if (retain && snapshotActive) {
+        stagedImage.insert(topic.name, RetainedValue { topic, std::move(payload), qos });
+        return;
+    }
+
+    service->writeMqtt(topic, std::move(payload), qos, retain);
+}
+
+void PanelBridge::writeMqtt(const PublishTopic &topic, const char *message,
+                            QosLevel qos, bool retain)
+{
+    writeMqtt(topic, QByteArray(message), qos, retain);
+}
+
+void PanelBridge::writeMqtt(const PublishTopic &topic, QString message,
+                            QosLevel qos, bool retain)
+{
+    writeMqtt(topic, message.toUtf8(), qos, retain);
+}
+
+void PanelBridge::writeMqtt(QString topic, const char *message,
+                            QosLevel qos, bool retain)
+{
+    writeMqtt(PublishTopic(topic), QByteArray(message), qos, retain);
+}
+
+void PanelBridge::writeMqtt(QString topic, QString message,
+                            QosLevel qos, bool retain)
+{
+    writeMqtt(PublishTopic(topic), message.toUtf8(), qos, retain);
+}
+
+void PanelBridge::onIt100Connected()
+{
+    // This is a TCP connection only and does not infer
+    // good communications with the module
+    // See ::onIt100CommunicationsBegin() for this
+    writeMqtt(QString("client/%1").arg(panelName),
+              "{ \"connected:\" : \"true\" }", QOS_1, true);
+    writeLog(QString("Connected to IT100 at %1")
+             .arg(linkName), LOG_LEVEL_DEBUG);
+    graylog->sendMessage("Connected to it100", LevelInformational);
+}
+
+void PanelBridge::onIt100Disconnected()
+{
+    writeLog(QString("DISCONNECTED from IT100 at %1")
+             .arg(linkName), LOG_LEVEL_DEBUG);
+    graylog->sendMessage("Disconnected from it100", LevelNotice);
+}
+
+void PanelBridge::onIt100CommunicationsBegin()
+{
+    // writeMqtt(QString("client-status/%1").arg(panelName), "{ \"connected:" : true", QOS_1, true);
+    writeMqtt(topics.system(TopicTable::SystemEvent),"it100 module is communicating");
+    writeMqtt(topics.system(TopicTable::SystemAvailability),"online",QOS_1,true);
+    writeLog("IT-100 is communicating", LOG_LEVEL_NOTICE);
+    graylog->sendMessage("it100 module is communicating", LevelNotice);
+    moduleStatus = COMP_STATUS_OK;
+    
+    service->updateServiceStatus();
+}
+
+void PanelBridge::onIt100KeySequenceComplete(int keys, bool complete)
+{
+    writeMqtt(topics.system(TopicTable::SystemKeypadResult),
+              QString("{ \"keys\":%1, \"complete\":%2 }")
+                  .arg(keys).arg(complete ? "true" : "false"), QOS_1);
+}
+
+void PanelBridge::onKeySequenceRejected(int keys)
+{
+    QString logMessage = QString("Keypad sequence not accepted (%1 keys)").arg(keys);
+    graylog->sendMessage(logMessage, LevelError);
+    writeLog(logMessage, LOG_LEVEL_ERROR);
+}
+
+void PanelBridge::onIt100CommunicationsTimeout()
+{
+    // writeMqtt(QString("status/%1").arg(panelName),"fault",QOS_1,true);
+    writeMqtt(topics.system(TopicTable::SystemEvent),"it100 module communications timeout");
+    writeMqtt(topics.system(TopicTable::SystemAvailability),"offline",QOS_1,true);
+    writeLog("Communications with IT100 has timed out", LOG_LEVEL_ERROR);
+    graylog->sendMessage("it100 module communications timeout", LevelNotice);
+    moduleStatus = COMP_STATUS_FAILED;
+
+    service->updateServiceStatus();
+}
+
+/**
+  * onPanelEvent(event)
+  * Called by IT100 once for every received line that reports a change
+  */
+void PanelBridge::onPanelEvent(const it100::PanelEvent &event)
+{
+    switch (event.type) {
+
+    case it100::PanelEvent::Zone:
+        onIt100ZoneStatusChange(event.zone, event.partition,
+                                static_cast<it100::ZoneStatus>(event.status));
+        break;
+
+    case it100::PanelEvent::Partition:
+        onIt100PartitionStatusChange(event.partition,
+                                     static_cast<it100::PartitionStatus>(event.status));
+        break;
+
+    case it100::PanelEvent::PartitionArmed:
+        onIt100PartitionArmedDescriptive(event.partition,
+                                         static_cast<it100::PartitionArmedMode>(event.status));
+        break;
+
+    case it100::PanelEvent::User: {
+        it100::UserEventType type = static_cast<it100::UserEventType>(event.status);
+        processIt100UserEvent(type, event.partition, event.user);
+        if (type == it100::UserClosing)
+            onIt100PartitionStatusChange(event.partition,
+                                         it100::PARTITION_STATUS_USER_CLOSING);
+        else if (type == it100::UserInvalidAccessCode)
+            onIt100PartitionStatusChange(event.partition,
+                                         it100::PARTITION_STATUS_INVALID_ACCESS_CODE);
+        break;
+    }
+
+    case it100::PanelEvent::Trouble:
+        onIt100TroubleEvent(static_cast<it100::TroubleEvent>(event.status));
+        break;
+
+    case it100::PanelEvent::KeypadDisplay:
+        onIt100VirtualKeypadDisplayUpdate();
+        break;
+    }
+}
+
+void PanelBridge::onSnapshotBegin()
+{
+    stagedImage.clear();
+    snapshotActive = true;
+}
+
+/**
+  * onSnapshotComplete(elapsedMsecs, complete)
+  * Publish the staged topics, of which the service's retained cache
+  * lets through only those the snapshot changed, then the synced
+  * marker with the time the panel took to report
+  */
+void PanelBridge::onSnapshotComplete(int64_t elapsedMsecs, bool complete)
+{
+    snapshotActive = false;
+
+    int changed = 0;
+    for (auto it = stagedImage.constBegin(); it != stagedImage.constEnd(); ++it) {
+        if (service->writeMqtt(it.value().topic, it.value().payload,
+                               it.value().qos, true))
+            changed++;
+    }
+
+    writeMqtt(topics.system(TopicTable::SystemSynced),
+              QString("{ \"complete\":%1, \"elapsed_ms\":%2, \"topics\":%3, \"changed\":%4 }")
+                  .arg(complete ? "true" : "false")
+                  .arg(elapsedMsecs)
+                  .arg(stagedImage.count())
+                  .arg(changed), QOS_1, true);
+
+    writeLog(QString("Panel status %1 in %2 ms; %3 of %4 retained topics changed")
+             .arg(complete ? "synced" : "partially synced")
+             .arg(elapsedMsecs).arg(changed).arg(stagedImage.count()),
+             complete ? LOG_LEVEL_NOTICE : LOG_LEVEL_ERROR);
+
+    stagedImage.clear();
+}
+
+void PanelBridge::onIt100ZoneStatusChange(int16_t zone, int16_t partition, it100::ZoneStatus status)
+{
+        switch (status) {
+            
+        case it100::ZONE_STATUS_ALARM:
+            if (!snapshotActive) {
+                writeMqtt(topics.zone(zone, TopicTable::ZoneEvent),"alarm");
+                graylog->sendMessage(QString("zone %1 is in alarm!").arg(zone), LevelCritical);
+            }
+            writeMqtt(topics.zone(zone, TopicTable::ZoneCondition),"alarm",QOS_1,true);
+            break;
+            
+        case it100::ZONE_STATUS_ALARM_RESTORED:
+            if (!snapshotActive) {
+                writeMqtt(topics.zone(zone, TopicTable::ZoneEvent),"alarm_restored");
+                writeMqtt(topics.system(TopicTable::SystemAlarmEvent),"alarm_restored");
+                graylog->sendMessage(QString("zone %1 alarm restored!")
+                                     .arg(zone), LevelCritical);
+            }
+            break;
+            
+        case it100::ZONE_STATUS_OPEN:
+            if (!snapshotActive) {
+                writeMqtt(topics.zone(zone, TopicTable::ZoneEvent),"violated");
+                graylog->sendMessage(QString("Zone %1 Open").arg(zone), LevelInformational);
+            }
+            writeMqtt(topics.zone(zone, TopicTable::ZoneState),"open",QOS_1,true);
+            writeMqtt(topics.zone(zone, TopicTable::ZoneCondition),"violated",QOS_1,true);
+            break;
+            
+        case it100::ZONE_STATUS_RESTORED:
+            if (!snapshotActive) {
+                writeMqtt(topics.zone(zone, TopicTable::ZoneEvent),"restored");
+                graylog->sendMessage(QString("Zone %1 Restored").arg(zone), LevelInformational);
+            }
+            writeMqtt(topics.zone(zone, TopicTable::ZoneState),"closed",QOS_1,true);
+            writeMqtt(topics.zone(zone, TopicTable::ZoneCondition),"secure",QOS_1,true);
+            break;
+            
+        case it100::ZONE_STATUS_TAMPER:
+            if (!snapshotActive) {
+                writeMqtt(topics.zone(zone, TopicTable::ZoneEvent),"tamper");
+                graylog->sendMessage(QString("Zone %1 Tamper").arg(zone), LevelCritical);
+            }
+            writeMqtt(topics.zone(zone, TopicTable::ZoneCondition),"tamper",QOS_1,true);
+            break;
+            
+        case it100::ZONE_STATUS_TAMPER_RESTORED:
+            if (!snapshotActive) {
+                writeMqtt(topics.zone(zone, TopicTable::ZoneEvent),"tamper_restored");
+                graylog->sendMessage(QString("Zone %1 Tamper Restored")
+                                     .arg(zone), LevelNotice);
+            }
+            break;
+            
+        case it100::ZONE_STATUS_FAULT:
+            if (!snapshotActive) {
+                writeMqtt(topics.zone(zone, TopicTable::ZoneEvent),"fault",QOS_1,true);
+                graylog->sendMessage(QString("Zone %1 Fault").arg(zone), LevelCritical);
+            }
+            writeMqtt(topics.zone(zone, TopicTable::ZoneCondition),"fault",QOS_1,true);
+            break;
+            
+        case it100::ZONE_STATUS_FAULT_RESTORED:
+            if (!snapshotActive) {
+                writeMqtt(topics.zone(zone, TopicTable::ZoneEvent),"fault_restored");
+                graylog->sendMessage(QString("Zone %1 Fault Restored")
+                                     .arg(zone), LevelNotice);
+            }
+            // how do we determine the condition of the zone now?? does it100 send a restored/violated?
+            break;
+
+//            static const QByteArray CMD_LCD_UPDATE;
+//            static const QByteArray CMD_LCD_CURSOR;
+//            static const QByteArray CMD_LED_STATUS;
+//            static const QByteArray CMD_BEEP_STATUS;
+//            static const QByteArray CMD_TONE_STATUS;
+//            static const QByteArray CMD_BUZZER_STATUS;
+//            static const QByteArray CMD_DOOR_CHIME_STATUS;
+
+        default:
+            break;
+        }
+
+        writeLog(QString("ZoneStatusChange(partition=%1,zone=%2,status=%3)")
+                 .arg(partition).arg(zone).arg((qint8)status), LOG_LEVEL_DEBUG);
+}
+
+void PanelBridge::processIt100UserEvent(it100::UserEventType type,
+                                 int16_t partition, int16_t user)
+{
+    QString userLabel = nameFromUserCodeSlot(user);
+
+    if (type == it100::UserOpening) {
+        writeMqtt(topics.partition(partition, TopicTable::PartitionUserDisarmed),
+                  QString("%1:%2").arg(user).arg(userLabel),QOS_1);
+    } else if (type == it100::UserClosing) {
+        writeMqtt(topics.partition(partition, TopicTable::PartitionUserArmed),
+                  QString("%1:%2").arg(user).arg(userLabel),QOS_1);
+    }
+
+    // produce json string of event
+    QString userStr;
+    if (user >= 0) userStr = QString(", \"user\":%1, \"label\":\"%2\"")
+            .arg(user).arg(userLabel);
+    QString eventJson = QString("{ \"type\":\"%1\", \"partition\":%2%3 }")
+            .arg(it100::IT100::userEventTypeToString(type))
+            .arg(partition).arg(userStr);
+
+    writeMqtt(topics.partition(partition, TopicTable::PartitionUserEvent),eventJson, QOS_1);
+
+    writeLog(QString("UserEvent: type=%1; partition=%2, user=%3, label=%4")
+            .arg(it100::IT100::userEventTypeToString(type))
+            .arg(partition).arg(user).arg(userLabel), LOG_LEVEL_NOTICE);
+}
+
+void PanelBridge::onIt100PartitionArmedDescriptive(int16_t partition,
+                                                   it100::PartitionArmedMode mode)
+{
+    QString armed_mode = "armed_away";  
+    QString hass_armed_mode = "armed_away";
+    if (mode == it100::PARTITION_ARMED_STAY || mode == it100::PARTITION_ARMED_STAY_NODELAY) {
+        armed_mode = "armed_stay";
+        hass_armed_mode = "armed_home";
+        qDebug() << "ARMED STAY!";
+    }
+        
+    if (!snapshotActive)
+        writeMqtt(topics.partition(partition, TopicTable::PartitionEvent),armed_mode);
+
+    writeMqtt(topics.partition(partition, TopicTable::PartitionArmed),"1",QOS_1,true);
+    writeMqtt(topics.partition(partition, TopicTable::PartitionState),armed_mode,QOS_1,true);
+    writeMqtt(topics.partition(partition, TopicTable::PartitionHassState),hass_armed_mode,QOS_1,true);
+
+//    writeLog(QString("Alarm partition %1 armed").arg(partition), LOG_LEVEL_NOTICE);
+//    graylog->sendMessage(QString("Partition %1 Armed!").arg(partition), LevelInformational);
+    // panel.partition(partition)->armed = true;
+
+}
+
+void PanelBridge::onIt100PartitionStatusChange(int16_t partition,
+                                               it100::PartitionStatus status)
+{
+    switch (status) {
+    case it100::PARTITION_STATUS_ALARM:
+        if (!snapshotActive) {
+            writeMqtt(topics.partition(partition, TopicTable::PartitionEvent),"alarm");
+            writeLog(QString("Alarm partition %1 in ALARM")
+                     .arg(partition), LOG_LEVEL_NOTICE);
+            graylog->sendMessage(QString("Partition %1 is in Alarm!")
+                                 .arg(partition), LevelCritical);
+        }
+        writeMqtt(topics.partition(partition, TopicTable::PartitionState),"alarm",QOS_1,true);
+        writeMqtt(topics.partition(partition, TopicTable::PartitionHassState),"triggered",QOS_1,true);
+        writeMqtt(topics.partition(partition, TopicTable::PartitionCondition),"alarm",QOS_1,true);
+        break;
+
+    case it100::PARTITION_STATUS_DISARMED: // 655
+        // we do not have a partition condition -- that should come in another message
+        if (!snapshotActive) {
+            writeMqtt(topics.partition(partition, TopicTable::PartitionEvent),"disarmed");
+            writeLog(QString("Alarm partition %1 disarmed")
+                     .arg(partition), LOG_LEVEL_NOTICE);
+            graylog->sendMessage(QString("Partition %1 Disarmed!")
+                                 .arg(partition), LevelInformational);
+        }
+        writeMqtt(topics.partition(partition, TopicTable::PartitionHassState),"disarmed",QOS_1,true);
+        writeMqtt(topics.partition(partition, TopicTable::PartitionArmed),"0",QOS_1,true);
+        writeMqtt(topics.partition(partition, TopicTable::PartitionState),"disarmed",QOS_1,true);
+        panel.partition(partition)->armed = false;
+        break;
+
+    case it100::PARTITION_STATUS_READY:
+        if (!snapshotActive) {
+            writeMqtt(topics.partition(partition, TopicTable::PartitionEvent),"disarmed");
+            graylog->sendMessage(QString("Partition %1 is Ready")
+                                 .arg(partition), LevelInformational);
+        }
+        writeMqtt(topics.partition(partition, TopicTable::PartitionArmed),"0",QOS_1,true);
+        writeMqtt(topics.partition(partition, TopicTable::PartitionHassState),"disarmed",QOS_1,true);
+        writeMqtt(topics.partition(partition, TopicTable::PartitionState),"disarmed",QOS_1,true);
+        writeMqtt(topics.partition(partition, TopicTable::PartitionCondition),"ready",QOS_1,true);
+        break;
+
+    case it100::PARTITION_STATUS_NOT_READY:
+        if (!snapshotActive) {
+            writeMqtt(topics.partition(partition, TopicTable::PartitionEvent),"not_ready");
+            graylog->sendMessage(QString("Partition %1 NOT Ready")
+                                 .arg(partition), LevelInformational);
+        }
+        writeMqtt(topics.partition(partition, TopicTable::PartitionArmed),"0",QOS_1,true);
+        writeMqtt(topics.partition(partition, TopicTable::PartitionHassState),"disarmed",QOS_1,true);
+        writeMqtt(topics.partition(partition, TopicTable::PartitionState),"disarmed",QOS_1,true);
+        writeMqtt(topics.partition(partition, TopicTable::PartitionCondition),"not_ready",QOS_1,true);
+        break;
+        
+    case it100::PARTITION_STATUS_BUSY:
+        if (!snapshotActive)
+            writeMqtt(topics.partition(partition, TopicTable::PartitionEvent),"busy");
+        writeMqtt(topics.partition(partition, TopicTable::PartitionArmed),"0",QOS_1,true);
+        writeMqtt(topics.partition(partition, TopicTable::PartitionHassState),"disarmed",QOS_1,true);
+        writeMqtt(topics.partition(partition, TopicTable::PartitionState),"busy",QOS_1,true);
+        writeMqtt(topics.partition(partition, TopicTable::PartitionCondition),"busy",QOS_1,true);
+        break;
+
+    case it100::PARTITION_STATUS_READY_FORCE_ARM:
+        if (!snapshotActive) {
+            writeMqtt(topics.partition(partition, TopicTable::PartitionEvent),"ready_force_arm");
+            graylog->sendMessage(QString("Partition %1 Ready to Force Arm")
+                                 .arg(partition), LevelInformational);
+        }
+        writeMqtt(topics.partition(partition, TopicTable::PartitionArmed),"0",QOS_1,true);
+        writeMqtt(topics.partition(partition, TopicTable::PartitionHassState),"disarmed",QOS_1,true);
+        writeMqtt(topics.partition(partition, TopicTable::PartitionState),"disarmed",QOS_1,true);
+        writeMqtt(topics.partition(partition, TopicTable::PartitionCondition),"ready_force_arm",QOS_1,true);
+        break;
+
+    case it100::PARTITION_STATUS_EXIT_DELAY_IN_PROGRESS:
+        if (!snapshotActive) {
+            writeMqtt(topics.partition(partition, TopicTable::PartitionEvent),"exit_delay");
+            graylog->sendMessage(QString("Partition %1 Exit Delay in Progress")
+                                 .arg(partition), LevelInformational);
+        }
+        writeMqtt(topics.partition(partition, TopicTable::PartitionHassState),"arming",QOS_1,true);
+        writeMqtt(topics.partition(partition, TopicTable::PartitionState),"exit_delay",QOS_1,true);
+        writeMqtt(topics.partition(partition, TopicTable::PartitionCondition),"exit_delay",QOS_1,true);
+        break;
+
+    case it100::PARTITION_STATUS_ENTRY_DELAY_IN_PROGRESS:
+        if (!snapshotActive) {
+            writeMqtt(topics.partition(partition, TopicTable::PartitionEvent),"entry_delay");
+            graylog->sendMessage(QString("Partition %1 Entry Delay in Progress")
+                                 .arg(partition), LevelInformational);
+        }
+        writeMqtt(topics.partition(partition, TopicTable::PartitionHassState),"pending",QOS_1,true);
+        writeMqtt(topics.partition(partition, TopicTable::PartitionState),"entry_delay",QOS_1,true);
+        writeMqtt(topics.partition(partition, TopicTable::PartitionCondition),"entry_delay",QOS_1,true);
+        break;
+
+    // we need to break this out as a seperate EVENT as it tells us which user armed
+    
+//    case PARTITION_STATUS_USER_CLOSING:
+//        if (!snapshotActive)
+//            writeMqtt(topics.partition(partition, TopicTable::PartitionEvent),"user_closing");
+//        writeMqtt(topics.partition(partition, TopicTable::PartitionEvent),"user_closing");
+//        break;
+
+    case it100::PARTITION_STATUS_PARTIAL_CLOSING:
+        writeMqtt(topics.partition(partition, TopicTable::PartitionEvent),"partial_closing");
+        break;
+
+    case it100::PARTITION_STATUS_SPECIAL_CLOSING:
+        writeMqtt(topics.partition(partition, TopicTable::PartitionEvent),"special_closing");
+        break;
+
+    case it100::PARTITION_STATUS_INVALID_ACCESS_CODE:
+        writeMqtt(topics.partition(partition, TopicTable::PartitionEvent),"invalid_access_code");
+        writeLog(QString("Invalid access code on Partition %1")
+                 .arg(partition), LOG_LEVEL_ERROR);
+        graylog->sendMessage(QString("Partition %1 Invalid Access Code!")
+                             .arg(partition), LevelNotice);
+        break;
+
+    case it100::PARTITION_STATUS_FUNCTION_NOT_AVAILABLE:
+        writeMqtt(topics.partition(partition, TopicTable::PartitionEvent),"function_not_available");
+        writeLog(QString("Invalid access code on Partition %1")
+                 .arg(partition), LOG_LEVEL_ERROR);
+        break;
+
+    }
+    writeLog(QString("PartitionStatusChange(partition=%1,status=%2)")
+             .arg(partition).arg((quint8)status));
+}
+
+void PanelBridge::onIt100TroubleEvent(it100::TroubleEvent event)
+{
+
+    /*
+        TODO: Implement the following checks:
+        TROUBLE_TLM_1,
+        TROUBLE_TLM_1_RESTORE,
+        TROUBLE_TLM_2,
+        TROUBLE_TLM_2_RESTORE,
+        TROUBLE_FTC,
+        TROUBLE_BUFFER_NEAR_FULL,
+        TROUBLE_WIRELESS_KEY_LOW_BATTERY,
+        TROUBLE_WIRELESS_KEY_LOW_BATTERY_RESTORE,
+        TROUBLE_HANDHELD_KEYPAD_LOW_BATTERY,
+        TROUBLE_HANDHELD_KEYPAD_LOW_BATTERY_RESTORE,
+        TROUBLE_HOME_AUTOMATION,
+        TROUBLE_HOME_AUTOMATION_RESTORE
+      */
+
+    switch (event) {
+
+    case it100::TROUBLE_PANEL_BATTERY:
+        graylog->sendMessage("Trouble: Panel Battery", LevelError);
+        writeMqtt(topics.system(TopicTable::SystemEvent),"trouble_panel_battery");
+        break;
+
+    case it100::TROUBLE_PANEL_BATTERY_RESTORE:
+        graylog->sendMessage("Trouble: Panel Battery Restore", LevelNotice);
+        writeMqtt(topics.system(TopicTable::SystemEvent),"trouble_panel_battery_restore");
+        break;
+
+    case it100::TROUBLE_PANEL_AC:
+        graylog->sendMessage("Trouble: Panel AC", LevelError);
+        writeMqtt(topics.system(TopicTable::SystemEvent),"trouble_panel_ac");
+        break;
+
+    case it100::TROUBLE_PANEL_AC_RESTORE:
+        graylog->sendMessage("Trouble: Panel AC Restored", LevelNotice);
+        writeMqtt(topics.system(TopicTable::SystemEvent),"trouble_panel_ac_restore");
+        break;
+
+    case it100::TROUBLE_SYSTEM_BELL:
+        graylog->sendMessage("Trouble: System Bell", LevelCritical);
+        writeMqtt(topics.system(TopicTable::SystemEvent),"trouble_panel_bell");
+        break;
+
+    case it100::TROUBLE_SYSTEM_BELL_RESTORE:
+        graylog->sendMessage("Trouble: System Bell Restore", LevelNotice);
+        writeMqtt(topics.system(TopicTable::SystemEvent),"trouble_panel_bell_restore");
+        break;
+
+    case it100::TROUBLE_GENERAL_SYSTEM_TAMPER:
+        graylog->sendMessage("Trouble: General System Tamper", LevelCritical);
+        writeMqtt(topics.system(TopicTable::SystemEvent),"trouble_general_tamper");
+        break;
+
+    case it100::TROUBLE_GENERAL_SYSTEM_TAMPER_RESTORE:
+        graylog->sendMessage("Trouble: General System Tamper Restore", LevelNotice);
+        writeMqtt(topics.system(TopicTable::SystemEvent),"trouble_general_tamper_restore");
+        break;
+
+    case it100::TROUBLE_GENERAL_DEVICE_LOW_BATTERY:
+        graylog->sendMessage("Trouble: General Device Low Battery", LevelError);
+        writeMqtt(topics.system(TopicTable::SystemEvent),"trouble_general_device_low_battery");
+        break;
+
+    case it100::TROUBLE_GENERAL_DEVICE_LOW_BATTERY_RESTORE:
+        graylog->sendMessage("Trouble: General Device Low Battery Restore", LevelNotice);
+        writeMqtt(topics.system(TopicTable::SystemEvent),"trouble_general_device_low_battery_restore");
+        break;
+
+    default:
+        break;
+
+    }
+}
+
+// Write log entry to MQTT broker under this panel's name
+//
+void PanelBridge::writeLog(QString msg, LogLevel level)
+{
+    service->writeLog(panelName, msg, level);
+}
@@ -0,0 +1,128 @@
+#ifndef PANELBRIDGE_H
+#define PANELBRIDGE_H
+
+#ifndef QMQTT_LIBRARY
+#define QMQTT_LIBRARY
+#endif
+
+#include <QObject>
+#include <QSettings>
+#include <QMap>
+#include <QHash>
+
+#include "graylog.h"
+#include "it100.h"
+#include "it100linkhandoff.h"
+#include "alarmpanel.h"
+#include "topictable.h"
+#include <qmqtt/qmqtt.h>
+
+class It100Mqtt;
+
+enum LogLevel {
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_SECURITY,
+    LOG_LEVEL_NOTICE,
+    LOG_LEVEL_DEBUG
+};
+
+enum QosLevel {
+    QOS_0 = 0,
+    QOS_1 = 1,
+    QOS_2 = 2
+};
+
+/**
+  * PanelBridge
+  * One IT-100 and its topics. Owns the module, the panel state and
+  * the retained image under its own prefix; publishes through the
+  * service's shared MQTT client
+  */
+class PanelBridge : public QObject, public it100::PanelEventConsumer
+{
+    Q_OBJECT
+public:
+    PanelBridge(It100Mqtt *service, QString name, QString topicPrefix,
+                QObject *parent = nullptr);
+
+    // read the module settings from group; false if they are unusable
+    bool configure(QSettings &settings, QString group, bool debugMode,
+                   const SocketTuning *tuning);
+
+    void open();
+
+    QString name() const { return panelName; }
+    QString topicPrefix() const { return mqttTopicPrefix; }
+    it100::LinkHandoff *handoff() const { return link; }
+
+    // communicating, as last reported by the module
+    ComponentStatus status() const { return moduleStatus; }
+
+    // route this panel's command topics; subscribed by the router
+    void route(QMQTT::Router *router);
+
+    // log the handoff and module counters
+    void reportStats();
+
+    void writeLog(QString msg, LogLevel level = LOG_LEVEL_DEBUG);
+    void writeMqtt(const PublishTopic &topic, QByteArray payload, QosLevel qos = QOS_0, bool retain = false);
+    void writeMqtt(const PublishTopic &topic, const char *message, QosLevel qos = QOS_0, bool retain = false);
+    void writeMqtt(const PublishTopic &topic, QString message, QosLevel qos = QOS_0, bool retain = false);
+    void writeMqtt(QString topic, const char *message, QosLevel qos = QOS_0, bool retain = false);
+    void writeMqtt(QString topic, QString message, QosLevel qos = QOS_0, bool retain = false);
+
+    void onPanelEvent(const it100::PanelEvent &event) override;
+    void onSnapshotBegin() override;
+    void onSnapshotComplete(int64_t elapsedMsecs, bool complete) override;
+
+private:
+
+    void onKeypadMessage(const QMQTT::RoutedMessage &routed);
+    void onCommandMessage(const QMQTT::RoutedMessage &routed);
+
+    void onIt100ZoneStatusChange(int16_t zone, int16_t partition, it100::ZoneStatus status);
+    void processIt100UserEvent(it100::UserEventType type, int16_t partition, int16_t user);
+    void onIt100PartitionStatusChange(int16_t partition, it100::PartitionStatus status);
+    void onIt100PartitionArmedDescriptive(int16_t partition, it100::PartitionArmedMode mode);
+    void onIt100TroubleEvent(it100::TroubleEvent event);
+    void onIt100VirtualKeypadDisplayUpdate();
+
+    void onIt100Connected();
+    void onIt100Disconnected();
+    void onIt100CommunicationsBegin();
+    void onIt100CommunicationsTimeout();
+    void onIt100KeySequenceComplete(int keys, bool complete);
+    void onKeySequenceRejected(int keys);
+
+    QString nameFromUserCodeSlot(int32_t user);
+    bool loadUserSlots();
+
+    It100Mqtt *service;
+    Graylog *graylog;
+
+    it100::LinkHandoff *link = nullptr;
+    ComponentStatus moduleStatus = COMP_STATUS_UNKNOWN;
+    QString linkName;
+    AlarmPanel panel;
+
+    QString panelName;
+    QString mqttTopicPrefix; // idac/module/[panelName]
+    TopicTable topics;
+
+    QString configFile;
+    QString usersGroup;
+    QMap<int,QString> userSlots;
+
+    struct RetainedValue {
+        PublishTopic topic;
+        QByteArray payload;
+        QosLevel qos;
+    };
+
+    // retained topics as staged while the panel answers a status request
+    QHash<QString,RetainedValue> stagedImage;
+    bool snapshotActive = false;
+
+};
+
+#endif // PANELBRIDGE_H
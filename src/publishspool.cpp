@@ -0,0 +1,278 @@
+#include "publishspool.h"
+
+#include <QDateTime>
+#include <QDebug>
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char journalMagic[8] = { 'I', 'T', '1', '0', '0', 'S', 'P', '1' };
+
+// record: length of the rest, queuedAt, qos, retain, encoded topic
+// (which carries its own length), payload
+static const int recordFixedBytes = 4 + 8 + 1 + 1;
+
+PublishSpool::PublishSpool()
+{
+    policies[ClassEvent] = PolicyJournal;
+    policies[ClassState] = PolicyLatest;
+    policies[ClassLog] = PolicyDrop;
+}
+
+PublishSpool::~PublishSpool()
+{
+    closeJournal();
+}
+
+bool PublishSpool::policyFromString(QString name, Policy *policy)
+{
+    name = name.toLower();
+    if (name == "drop") *policy = PolicyDrop;
+    else if (name == "memory") *policy = PolicyMemory;
+    else if (name == "journal") *policy = PolicyJournal;
+    else if (name == "latest") *policy = PolicyLatest;
+    else return false;
+    return true;
+}
+
+PublishSpool::TopicClass PublishSpool::classify(const PublishTopic &topic, bool retain)
+{
+    if (topic.name.startsWith("log/")) return ClassLog;
+    return retain ? ClassState : ClassEvent;
+}
+
+int PublishSpool::entryBytes(const Entry &entry)
+{
+    return entry.topic.encoded.size() + entry.payload.size();
+}
+
+bool PublishSpool::enqueue(const PublishTopic &topic, QByteArray payload,
+                           quint8 qos, bool retain)
+{
+    Entry entry;
+    entry.topic = topic;
+    entry.payload = std::move(payload);
+    entry.qos = qos;
+    entry.retain = retain;
+    entry.queuedAt = QDateTime::currentMSecsSinceEpoch();
+
+    int bytes = entryBytes(entry);
+    bool memoryRoom = memoryUsed + bytes <= memoryLimit;
+
+    switch (policies[classify(topic, retain)]) {
+
+    case PolicyDrop:
+        break;
+
+    case PolicyLatest: {
+        auto it = latest.find(topic.name);
+        if (it != latest.end()) {
+            // a replaced value keeps its place in the age of the spool
+            memoryUsed -= entryBytes(it.value());
+            entry.queuedAt = it.value().queuedAt;
+            it.value() = std::move(entry);
+        } else {
+            latest.insert(topic.name, std::move(entry));
+        }
+        memoryUsed += bytes;
+        _stats.spooled++;
+        return true;
+    }
+
+    case PolicyMemory:
+        if (!memoryRoom) break;
+        memoryUsed += bytes;
+        memory.enqueue(std::move(entry));
+        _stats.spooled++;
+        return true;
+
+    case PolicyJournal:
+        // once anything is in the journal, newer events follow it there
+        // so they come back in order
+        if (memoryRoom && (!header || header->records == 0)) {
+            memoryUsed += bytes;
+            memory.enqueue(std::move(entry));
+            _stats.spooled++;
+            return true;
+        }
+        if (appendJournal(entry)) {
+            _stats.spooled++;
+            _stats.journalled++;
+            return true;
+        }
+        break;
+    }
+
+    _stats.dropped++;
+    return false;
+}
+
+bool PublishSpool::takeNext(Entry *entry)
+{
+    if (!memory.isEmpty()) {
+        *entry = memory.dequeue();
+        memoryUsed -= entryBytes(*entry);
+    } else if (!readJournal(entry)) {
+        if (latest.isEmpty()) return false;
+        auto it = latest.begin();
+        *entry = std::move(it.value());
+        latest.erase(it);
+        memoryUsed -= entryBytes(*entry);
+    }
+    _stats.replayed++;
+    return true;
+}
+
+int PublishSpool::depth() const
+{
+    return memory.count() + latest.count() + (header ? header->records : 0);
+}
+
+qint64 PublishSpool::oldestAgeMsecs() const
+{
+    qint64 oldest = 0;
+    if (!memory.isEmpty())
+        oldest = memory.head().queuedAt;
+    else if (header && header->records) {
+        qint64 queuedAt;
+        memcpy(&queuedAt, journal + header->readOffset + 4, sizeof(queuedAt));
+        oldest = queuedAt;
+    }
+    for (auto it = latest.constBegin(); it != latest.constEnd(); ++it)
+        if (!oldest || it.value().queuedAt < oldest) oldest = it.value().queuedAt;
+
+    return oldest ? QDateTime::currentMSecsSinceEpoch() - oldest : 0;
+}
+
+qint64 PublishSpool::journalBytes() const
+{
+    return header ? header->writeOffset - header->readOffset : 0;
+}
+
+// ####################
+// Memory-mapped journal
+// ####################
+
+/**
+  * openJournal(path, capacity)
+  * The file is sized to capacity and mapped whole; records are appended
+  * after the header and the offsets reset once they are all taken.
+  * The kernel writes the pages back, so a spool outlives a restart of
+  * the service but not necessarily of the host
+  */
+bool PublishSpool::openJournal(const QString &path, qint64 capacity)
+{
+    closeJournal();
+    if (capacity < qint64(sizeof(JournalHeader)) + 4096) return false;
+
+    int fd = ::open(path.toLocal8Bit().constData(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        qDebug() << qPrintable(QString("unable to open spool journal %1: %2")
+                               .arg(path).arg(strerror(errno)));
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) < 0 ||
+            (info.st_size != capacity && ftruncate(fd, capacity) < 0)) {
+        qDebug() << qPrintable(QString("unable to size spool journal %1: %2")
+                               .arg(path).arg(strerror(errno)));
+        ::close(fd);
+        return false;
+    }
+
+    void *map = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        qDebug() << qPrintable(QString("unable to map spool journal %1: %2")
+                               .arg(path).arg(strerror(errno)));
+        ::close(fd);
+        return false;
+    }
+
+    journalFd = fd;
+    journal = static_cast<char *>(map);
+    journalCapacity = capacity;
+    header = reinterpret_cast<JournalHeader *>(journal);
+
+    // keep what an earlier run left, if it still makes sense
+    bool valid = memcmp(header->magic, journalMagic, sizeof(journalMagic)) == 0 &&
+            header->readOffset >= qint64(sizeof(JournalHeader)) &&
+            header->readOffset <= header->writeOffset &&
+            header->writeOffset <= capacity && header->records >= 0;
+    if (!valid) {
+        memcpy(header->magic, journalMagic, sizeof(journalMagic));
+        header->readOffset = header->writeOffset = sizeof(JournalHeader);
+        header->records = 0;
+    } else if (header->records) {
+        qDebug() << qPrintable(QString("spool journal %1 holds %2 publishes from an earlier run")
+                               .arg(path).arg(header->records));
+    }
+    return true;
+}
+
+void PublishSpool::closeJournal()
+{
+    if (journal) munmap(journal, journalCapacity);
+    if (journalFd >= 0) ::close(journalFd);
+    journal = nullptr;
+    header = nullptr;
+    journalFd = -1;
+    journalCapacity = 0;
+}
+
+bool PublishSpool::appendJournal(const Entry &entry)
+{
+    if (!header) return false;
+
+    qint64 length = recordFixedBytes + entryBytes(entry);
+    if (header->writeOffset + length > journalCapacity) return false;
+
+    char *record = journal + header->writeOffset;
+    quint32 rest = length - 4;
+    memcpy(record, &rest, 4);
+    memcpy(record + 4, &entry.queuedAt, 8);
+    record[12] = char(entry.qos);
+    record[13] = char(entry.retain);
+    memcpy(record + recordFixedBytes, entry.topic.encoded.constData(),
+           entry.topic.encoded.size());
+    memcpy(record + recordFixedBytes + entry.topic.encoded.size(),
+           entry.payload.constData(), entry.payload.size());
+
+    // the record is complete before the header counts it
+    header->writeOffset += length;
+    header->records++;
+    return true;
+}
+
+bool PublishSpool::readJournal(Entry *entry)
+{
+    if (!header || header->records == 0) return false;
+
+    const char *record = journal + header->readOffset;
+    quint32 rest;
+    memcpy(&rest, record, 4);
+    int topicBytes = 2 + ((quint8(record[recordFixedBytes]) << 8) |
+                          quint8(record[recordFixedBytes + 1]));
+    int payloadBytes = int(rest) + 4 - recordFixedBytes - topicBytes;
+    if (payloadBytes < 0 || header->readOffset + rest + 4 > header->writeOffset) {
+        qDebug() << "spool journal is corrupt; discarding it";
+        header->readOffset = header->writeOffset = sizeof(JournalHeader);
+        header->records = 0;
+        return false;
+    }
+
+    memcpy(&entry->queuedAt, record + 4, 8);
+    entry->qos = quint8(record[12]);
+    entry->retain = record[13];
+    entry->topic.encoded = QByteArray(record + recordFixedBytes, topicBytes);
+    entry->topic.name = QString::fromUtf8(record + recordFixedBytes + 2, topicBytes - 2);
+    entry->payload = QByteArray(record + recordFixedBytes + topicBytes, payloadBytes);
+
+    header->readOffset += qint64(rest) + 4;
+    if (--header->records == 0)
+        header->readOffset = header->writeOffset = sizeof(JournalHeader);
+    return true;
+}
@@ -0,0 +1,113 @@
+#ifndef PUBLISHSPOOL_H
+#define PUBLISHSPOOL_H
+
+#include <QHash>
+#include <QQueue>
+#include <QString>
+#include <QByteArray>
+
+#include "topictable.h"
+
+/**
+  * PublishSpool
+  * Publishes held while the broker is unreachable. Entries queue in
+  * memory up to a byte limit, then append to a memory-mapped journal
+  * file; they are taken back oldest first. What is kept depends on
+  * the class of topic:
+  *   events (not retained)  - memory, then the journal
+  *   state (retained)       - the latest value of each topic only
+  *   log/...                - dropped
+  * Records left in the journal by an earlier run are replayed too
+  */
+class PublishSpool
+{
+public:
+
+    enum TopicClass {
+        ClassEvent,
+        ClassState,
+        ClassLog,
+        ClassCount
+    };
+
+    enum Policy {
+        PolicyDrop,
+        PolicyMemory,       // drop once the memory limit is reached
+        PolicyJournal,      // spill to the journal past the memory limit
+        PolicyLatest        // last value per topic, in memory
+    };
+
+    struct Entry {
+        PublishTopic topic;
+        QByteArray payload;
+        quint8 qos = 0;
+        bool retain = false;
+        qint64 queuedAt = 0;    // msecs since epoch
+    };
+
+    struct Stats {
+        uint64_t spooled = 0;
+        uint64_t journalled = 0;
+        uint64_t replayed = 0;
+        uint64_t dropped = 0;
+    };
+
+    inline static const int defaultMemoryLimit = 256 * 1024;
+
+    PublishSpool();
+    ~PublishSpool();
+
+    void setMemoryLimit(int bytes) { memoryLimit = bytes; }
+    void setPolicy(TopicClass topicClass, Policy policy) { policies[topicClass] = policy; }
+    static bool policyFromString(QString name, Policy *policy);
+
+    // false if the file cannot be used; events are then held in
+    // memory only
+    bool openJournal(const QString &path, qint64 capacity);
+
+    static TopicClass classify(const PublishTopic &topic, bool retain);
+
+    // false if the policy or a full spool dropped it
+    bool enqueue(const PublishTopic &topic, QByteArray payload, quint8 qos, bool retain);
+
+    // oldest first, latest state last; false once empty
+    bool takeNext(Entry *entry);
+
+    int depth() const;
+    qint64 oldestAgeMsecs() const;
+    int memoryBytes() const { return memoryUsed; }
+    qint64 journalBytes() const;
+    const Stats &stats() const { return _stats; }
+
+private:
+
+    struct JournalHeader {
+        char magic[8];
+        qint64 readOffset;
+        qint64 writeOffset;
+        qint64 records;
+    };
+
+    static int entryBytes(const Entry &entry);
+
+    bool appendJournal(const Entry &entry);
+    bool readJournal(Entry *entry);
+    void closeJournal();
+
+    Policy policies[ClassCount];
+    int memoryLimit = defaultMemoryLimit;
+    int memoryUsed = 0;
+
+    QQueue<Entry> memory;
+    QHash<QString,Entry> latest;
+
+    int journalFd = -1;
+    char *journal = nullptr;
+    qint64 journalCapacity = 0;
+    JournalHeader *header = nullptr;
+
+    Stats _stats;
+
+};
+
+#endif // PUBLISHSPOOL_H
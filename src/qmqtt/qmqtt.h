@@ -36,5 +36,7 @@
 #include "qmqtt_message.h"
 #include "qmqtt_client.h"
 #include "qmqtt_router.h"
+#include "qmqtt_routesubscription.h"
+#include "qmqtt_routedmessage.h"
 
 #endif // QMQTT_H
@@ -177,6 +177,67 @@ bool Client::isConnected()
     return d->network->isConnected();
 }
 
+int Client::inFlightWindow() const
+{
+    Q_D(const Client);
+    return d->inflightWindow;
+}
+
+void Client::setInFlightWindow(int window)
+{
+    Q_D(Client);
+    /* an id must stay free for SUBSCRIBE and UNSUBSCRIBE */
+    d->inflightWindow = qBound(1, window, 65534);
+}
+
+int Client::retransmitTimeout() const
+{
+    Q_D(const Client);
+    return d->retransmitMsecs;
+}
+
+void Client::setRetransmitTimeout(int msecs)
+{
+    Q_D(Client);
+    d->retransmitMsecs = msecs;
+}
+
+int Client::inFlight() const
+{
+    Q_D(const Client);
+    return d->inflight.size();
+}
+
+bool Client::inFlightFull() const
+{
+    Q_D(const Client);
+    return d->inflight.size() >= d->inflightWindow;
+}
+
+Client::InFlightStats Client::inFlightStats() const
+{
+    Q_D(const Client);
+    return d->inflightStats;
+}
+
+void Client::setWriteCoalescing(int maxBytes, int delayMsecs)
+{
+    Q_D(Client);
+    d->network->setCoalescing(maxBytes, delayMsecs);
+}
+
+Network::Stats Client::writeStats() const
+{
+    Q_D(const Client);
+    return d->network->stats();
+}
+
+void Client::setMaxPacketSize(int bytes)
+{
+    Q_D(Client);
+    d->network->setMaxPacketSize(bytes);
+}
+
 
 /*----------------------------------------------------------------
  * MQTT Command
@@ -193,6 +254,8 @@ void Client::onConnected()
     qCDebug(client) << "Sock Connected....";
     d->sendConnect();
     d->startKeepalive();
+    // whatever the broker had not acknowledged before the drop
+    d->retransmit(true);
     emit connected();
 }
 
@@ -200,10 +263,20 @@ quint16 Client::publish(Message &message)
 {
     Q_D(Client);
     quint16 msgid = d->sendPublish(message);
-    emit published(message);
+    if(msgid || message.qos() == MQTT_QOS0) {
+        emit published(message);
+    }
     return msgid;
 }
 
+quint16 Client::publishEncoded(const QByteArray &encodedTopic,
+                               const QByteArray &payload,
+                               quint8 qos, bool retain)
+{
+    Q_D(Client);
+    return d->sendPublish(encodedTopic, payload, qos, retain);
+}
+
 void Client::puback(quint8 type, quint16 msgid)
 {
     Q_D(Client);
@@ -247,7 +320,7 @@ void Client::onDisconnected()
 
 //---------------------------------------------
 //---------------------------------------------
-void Client::onReceived(Frame &frame)
+void Client::onReceived(FrameView &frame)
 {
     quint8 qos = 0;
     bool retain, dup;
@@ -274,7 +347,7 @@ void Client::onReceived(Frame &frame)
         }
         message.setId(mid);
         message.setTopic(topic);
-        message.setPayload(frame.data());
+        message.setPayload(frame.readRest());
         message.setQos(qos);
         message.setRetain(retain);
         message.setDup(dup);
@@ -293,6 +366,7 @@ void Client::onReceived(Frame &frame)
         emit subacked(mid, qos);
         break;
     case UNSUBACK:
+        mid = frame.readInt();
         emit unsubacked(mid);
         break;
     case PINGRESP:
@@ -323,7 +397,9 @@ void Client::handlePublish(Message & message)
 void Client::handlePuback(quint8 type, quint16 msgid)
 {
     Q_D(Client);
-    if(type == PUBREC) {
+    if(type == PUBACK) {
+        d->releaseInFlight(msgid);
+    } else if(type == PUBREC) {
         d->sendPuback(PUBREL, msgid);
     } else if (type == PUBREL) {
         d->sendPuback(PUBCOMP, msgid);
@@ -331,5 +407,11 @@ void Client::handlePuback(quint8 type, quint16 msgid)
     emit pubacked(type, msgid);
 }
 
+void Client::onRetransmitTimeout()
+{
+    Q_D(Client);
+    d->retransmit(false);
+}
+
 } // namespace QMQTT
 
@@ -122,6 +122,45 @@ public:
 
     State state() const;
 
+    /*
+     * QoS 1 publishes are kept until their PUBACK, sent again with DUP
+     * set after the retransmit timeout and on reconnect. A QoS 1
+     * publish made with the window full is refused; callers check
+     * inFlightFull() and hold back
+     */
+    struct InFlightStats {
+        int depthMax = 0;
+        quint64 acked = 0;
+        quint64 retransmits = 0;
+        quint64 unknownAcks = 0;
+        qint64 ackLatencyLastMsecs = 0;     // first send to PUBACK
+        qint64 ackLatencyMaxMsecs = 0;
+        qint64 ackLatencyAvgMsecs = 0;      // moving average
+    };
+
+    int inFlightWindow() const;
+    void setInFlightWindow(int window);
+    int retransmitTimeout() const;
+    void setRetransmitTimeout(int msecs);
+    int inFlight() const;
+    bool inFlightFull() const;
+    InFlightStats inFlightStats() const;
+
+    // see Network::setCoalescing()
+    void setWriteCoalescing(int maxBytes, int delayMsecs);
+    Network::Stats writeStats() const;
+
+    // see Network::setMaxPacketSize()
+    void setMaxPacketSize(int bytes);
+
+    /*
+     * Publish to a topic already encoded with Frame::encodeString();
+     * returns the message id, 0 for QoS 0 or a publish refused with the
+     * in-flight window full. published() is not emitted
+     */
+    quint16 publishEncoded(const QByteArray &encodedTopic, const QByteArray &payload,
+                           quint8 qos = 0, bool retain = false);
+
     /*
      * MQTT Command
      */
@@ -141,6 +180,7 @@ public slots:
 
 signals:
     void connected();
+    void socketConnected(qintptr descriptor);
     void error(QAbstractSocket::SocketError);
     void connacked(quint8 ack);
     //send PUBLISH and receive PUBACK
@@ -161,10 +201,11 @@ signals:
 private slots:
     void onConnected();
     void onDisconnected();
-    void onReceived(Frame & frame);
+    void onReceived(FrameView & frame);
     void handlePublish(Message &message);
     void handleConnack(quint8 ack);
     void handlePuback(quint8 type, quint16 msgid);
+    void onRetransmitTimeout();
 
 private:
     ClientPrivate *const  d_ptr;
@@ -41,9 +41,12 @@ ClientPrivate::ClientPrivate(Client *qt) :
     host("localhost"),
     port(1883),
     keepalive(300),
+    inflightWindow(16),
+    retransmitMsecs(10000),
     q_ptr(qt)
 {
     gmid= 1;
+    clock.start();
 }
 
 ClientPrivate::~ClientPrivate()
@@ -59,14 +62,19 @@ void ClientPrivate::init(QObject * parent)
         timer = new QTimer(q);
     }
     QObject::connect(timer, SIGNAL(timeout()), q, SLOT(ping()));
+    if(!retransmitTimer) {
+        retransmitTimer = new QTimer(q);
+    }
+    QObject::connect(retransmitTimer, SIGNAL(timeout()), q, SLOT(onRetransmitTimeout()));
     if(!network){
         network = new Network(q);
     }
     //TODO: FIXME LATER, how to handle socket error?
+    QObject::connect(network, SIGNAL(socketConnected(qintptr)), q, SIGNAL(socketConnected(qintptr)));
     QObject::connect(network, SIGNAL(connected()), q, SLOT(onConnected()));
     QObject::connect(network, SIGNAL(error(QAbstractSocket::SocketError)), q, SIGNAL(error(QAbstractSocket::SocketError)));
     QObject::connect(network, SIGNAL(disconnected()), q, SLOT(onDisconnected()));
-    QObject::connect(network, SIGNAL(received(Frame &)), q, SLOT(onReceived(Frame &)));
+    QObject::connect(network, SIGNAL(received(FrameView &)), q, SLOT(onReceived(FrameView &)));
 }
 
 void ClientPrivate::init(const QString &host, int port, QObject * parent)
@@ -131,24 +139,124 @@ void ClientPrivate::sendConnect()
 }
 
 quint16 ClientPrivate::sendPublish(Message &msg)
+{
+    // ids come from nextmid() alone so none is reused while in flight
+    msg.setId(sendPublish(Frame::encodeString(msg.topic()), msg.payload(),
+                          msg.qos(), msg.retain()));
+    return msg.id();
+}
+
+/*
+ * The topic is already in its wire form. QoS 1 publishes are kept until
+ * their PUBACK so they can be sent again; with the window full one is
+ * refused and 0 returned
+ */
+quint16 ClientPrivate::sendPublish(const QByteArray &encodedTopic,
+                                   const QByteArray &payload,
+                                   quint8 qos, bool retain)
 {
     quint8 header = PUBLISH;
-    header = SETRETAIN(header, msg.retain() ? 1 : 0);
-    header = SETQOS(header, msg.qos());
-    header = SETDUP(header, msg.dup() ? 1 : 0);
-    Frame frame(header);
-    frame.writeString(msg.topic());
-    if(msg.qos() > MQTT_QOS0) {
-        if(msg.id() == 0) {
-            msg.setId(gmid++);
+    header = SETRETAIN(header, retain ? 1 : 0);
+    header = SETQOS(header, qos);
+    quint16 mid = 0;
+    if(qos > MQTT_QOS0) {
+        if(inflight.size() >= inflightWindow) {
+            qCWarning(client) << "publish refused, in-flight window full:" << inflight.size();
+            return 0;
+        }
+        mid = nextmid();
+        if(mid == 0) {
+            return 0;
         }
-        frame.writeInt(msg.id());
     }
-    if(!msg.payload().isEmpty()) {
-        frame.writeRawData(msg.payload());
+    writePublish(header, encodedTopic, mid, payload);
+
+    if(qos == MQTT_QOS1) {
+        qint64 now = clock.elapsed();
+        inflight.insert(mid, InFlight { encodedTopic, payload, retain, now, now });
+        inflightOrder.append(mid);
+        if(inflight.size() > inflightStats.depthMax) {
+            inflightStats.depthMax = inflight.size();
+        }
+        if(!retransmitTimer->isActive()) {
+            retransmitTimer->start(qMax(retransmitMsecs / 4, 250));
+        }
+    }
+    return mid;
+}
+
+/*
+ * The fixed header and id are built on the stack; the parts are
+ * gathered with the other frames of this event loop iteration
+ */
+void ClientPrivate::writePublish(quint8 header, const QByteArray &encodedTopic,
+                                 quint16 mid, const QByteArray &payload)
+{
+    bool withId = GETQOS(header) > MQTT_QOS0;
+    int length = encodedTopic.size() + payload.size() + (withId ? 2 : 0);
+
+    char fixed[5];
+    fixed[0] = (char)header;
+    int fixedLength = 1 + Frame::encodeLength(fixed + 1, length);
+    network->sendData(fixed, fixedLength);
+    network->sendData(encodedTopic.constData(), encodedTopic.size());
+    if(withId) {
+        char id[2] = { (char)MSB(mid), (char)LSB(mid) };
+        network->sendData(id, 2);
+    }
+    if(!payload.isEmpty()) {
+        network->sendData(payload.constData(), payload.size());
+    }
+    network->endFrame();
+}
+
+void ClientPrivate::releaseInFlight(quint16 mid)
+{
+    auto it = inflight.find(mid);
+    if(it == inflight.end()) {
+        inflightStats.unknownAcks++;
+        return;
+    }
+
+    qint64 latency = clock.elapsed() - it.value().firstSentAt;
+    inflightStats.acked++;
+    inflightStats.ackLatencyLastMsecs = latency;
+    if(latency > inflightStats.ackLatencyMaxMsecs) {
+        inflightStats.ackLatencyMaxMsecs = latency;
+    }
+    inflightStats.ackLatencyAvgMsecs = inflightStats.ackLatencyAvgMsecs
+            ? (inflightStats.ackLatencyAvgMsecs * 7 + latency) / 8 : latency;
+
+    inflight.erase(it);
+    inflightOrder.removeOne(mid);
+    if(inflight.isEmpty()) {
+        retransmitTimer->stop();
+    }
+}
+
+/*
+ * Send again, with DUP set, what has waited longer than the retransmit
+ * timeout, or everything after a reconnect
+ */
+void ClientPrivate::retransmit(bool all)
+{
+    if(!network->isConnected()) {
+        return;
+    }
+    qint64 now = clock.elapsed();
+    foreach(quint16 mid, inflightOrder) {
+        InFlight &entry = inflight[mid];
+        if(!all && now - entry.sentAt < retransmitMsecs) {
+            continue;
+        }
+        quint8 header = PUBLISH;
+        header = SETRETAIN(header, entry.retain ? 1 : 0);
+        header = SETQOS(header, MQTT_QOS1);
+        header = SETDUP(header, 1);
+        writePublish(header, entry.encodedTopic, mid, entry.payload);
+        entry.sentAt = now;
+        inflightStats.retransmits++;
     }
-    network->sendFrame(frame);
-    return msg.id();
 }
 
 void ClientPrivate::sendPuback(quint8 type, quint16 mid)
@@ -171,7 +279,7 @@ quint16 ClientPrivate::sendSubscribe(const QString & topic, quint8 qos)
 
 quint16 ClientPrivate::sendUnsubscribe(const QString &topic)
 {
-    quint16 mid = gmid++;
+    quint16 mid = nextmid();
     Frame frame(SETQOS(UNSUBSCRIBE, MQTT_QOS1));
     frame.writeInt(mid);
     frame.writeString(topic);
@@ -214,9 +322,18 @@ QString ClientPrivate::randomClientId()
     return "QMQTT-" + QString::number(QDateTime::currentMSecsSinceEpoch() % 1000000);
 }
 
+// 0 is not a valid id, and one still in flight is not reused;
+// 0 is returned if every id is in flight
 quint16 ClientPrivate::nextmid()
 {
-    return gmid++;
+    for(int tries = 0; tries < 65536; tries++) {
+        quint16 mid = gmid++;
+        if(mid != 0 && !inflight.contains(mid)) {
+            return mid;
+        }
+    }
+    qCWarning(client) << "no message id free";
+    return 0;
 }
 
 } // namespace QMQTT
@@ -36,10 +36,14 @@
 #include <QPointer>
 #include <QTimer>
 #include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
 #include <QHostInfo>
 #include <QLoggingCategory>
 
 #include "qmqtt_global.h"
+#include "qmqtt_client.h"
 #include "qmqtt_message.h"
 #include "qmqtt_will.h"
 #include "qmqtt_network.h"
@@ -72,6 +76,22 @@ public:
     QPointer<QMQTT::Network> network;
     QPointer<QTimer> timer;
 
+    // QoS 1 publishes awaiting their PUBACK, oldest first in inflightOrder
+    struct InFlight {
+        QByteArray encodedTopic;
+        QByteArray payload;
+        bool retain;
+        qint64 firstSentAt;     // msecs, clock
+        qint64 sentAt;
+    };
+    QHash<quint16, InFlight> inflight;
+    QList<quint16> inflightOrder;
+    int inflightWindow;
+    int retransmitMsecs;
+    QPointer<QTimer> retransmitTimer;
+    QElapsedTimer clock;
+    Client::InFlightStats inflightStats;
+
 
 
 public slots:
@@ -81,7 +101,11 @@ public slots:
     quint16 sendUnsubscribe(const QString &topic);
     quint16 sendSubscribe(const QString &topic, quint8 qos);
     quint16 sendPublish(Message &msg);
+    quint16 sendPublish(const QByteArray &encodedTopic, const QByteArray &payload,
+                        quint8 qos, bool retain);
     void sendPuback(quint8 type, quint16 mid);
+    void releaseInFlight(quint16 mid);
+    void retransmit(bool all);
     void sendDisconnect();
     void disconnect();
     void startKeepalive();
@@ -90,6 +114,8 @@ public slots:
 private:
     QString randomClientId();
     quint16 nextmid();
+    void writePublish(quint8 header, const QByteArray &encodedTopic,
+                      quint16 mid, const QByteArray &payload);
     Client * const q_ptr;
 
 
@@ -75,8 +75,8 @@ char Frame::readChar()
 
 int Frame::readInt()
 {
-    char msb = _data.at(0);
-    char lsb = _data.at(1);
+    quint8 msb = _data.at(0);
+    quint8 lsb = _data.at(1);
     _data.remove(0, 2);
     return (msb << 8) + lsb;
 }
@@ -125,6 +125,17 @@ void Frame::write(QDataStream &stream)
     stream.writeRawData(_data.data(), _data.size());
 }
 
+QByteArray Frame::encodeString(const QString &string)
+{
+    QByteArray utf8 = string.toUtf8();
+    QByteArray encoded;
+    encoded.reserve(utf8.size() + 2);
+    encoded.append(MSB(utf8.size()));
+    encoded.append(LSB(utf8.size()));
+    encoded.append(utf8);
+    return encoded;
+}
+
 void Frame::encodeLength(QByteArray &lenbuf, int length)
 {
     char d;
@@ -138,4 +149,55 @@ void Frame::encodeLength(QByteArray &lenbuf, int length)
     } while (length > 0);
 }
 
+int Frame::encodeLength(char *buf, int length)
+{
+    int used = 0;
+    do {
+        char d = length % 128;
+        length /= 128;
+        if (length > 0) {
+            d |= 0x80;
+        }
+        buf[used++] = d;
+    } while (length > 0 && used < 4);
+    return used;
+}
+
+/*
+ * Short frames read as zeros rather than past the end
+ */
+char FrameView::readChar()
+{
+    if(_pos >= _size) {
+        return 0;
+    }
+    return _data[_pos++];
+}
+
+quint16 FrameView::readInt()
+{
+    if(_size - _pos < 2) {
+        _pos = _size;
+        return 0;
+    }
+    quint16 i = ((quint8)_data[_pos] << 8) | (quint8)_data[_pos + 1];
+    _pos += 2;
+    return i;
+}
+
+QString FrameView::readString()
+{
+    int len = qMin<int>(readInt(), _size - _pos);
+    QString s = QString::fromUtf8(_data + _pos, len);
+    _pos += len;
+    return s;
+}
+
+QByteArray FrameView::readRest()
+{
+    QByteArray rest(_data + _pos, _size - _pos);
+    _pos = _size;
+    return rest;
+}
+
 } // namespace QMQTT
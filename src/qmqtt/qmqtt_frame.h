@@ -109,12 +109,45 @@ public:
     //TODO: FIXME LATER
     void write(QDataStream &stream);
 
+    // MQTT string: two byte length then the UTF-8 bytes
+    static QByteArray encodeString(const QString &string);
+    static void encodeLength(QByteArray & lenbuf, int length);
+    // into buf, which must hold 4 bytes; returns the bytes used
+    static int encodeLength(char *buf, int length);
+
 private:
-    void encodeLength(QByteArray & lenbuf, int length);
     quint8 _header;
     QByteArray _data;
 };
 
+/*
+ * Read side of an inbound packet: a cursor over bytes owned by the
+ * caller, valid only while they are. Fields are decoded in place
+ */
+class FrameView
+{
+public:
+    FrameView(quint8 header, const QByteArray &data) :
+        _header(header), _data(data.constData()), _size(data.size()), _pos(0) {}
+    FrameView(quint8 header, const char *data, int size) :
+        _header(header), _data(data), _size(size), _pos(0) {}
+
+    quint8 header() const { return _header; }
+    int remaining() const { return _size - _pos; }
+
+    char readChar();
+    quint16 readInt();
+    QString readString();
+    // what is left, copied out
+    QByteArray readRest();
+
+private:
+    quint8 _header;
+    const char *_data;
+    int _size;
+    int _pos;
+};
+
 } // namespace QMQTT
 
 #endif // QMQTT_FRAME_H
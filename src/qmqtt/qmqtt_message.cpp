@@ -97,7 +97,7 @@ void Message::setDup(bool dup)
     _dup =dup;
 }
 
-QString Message::topic() const
+const QString &Message::topic() const
 {
     return _topic;
 }
@@ -107,7 +107,7 @@ void Message::setTopic(const QString & topic)
     _topic = topic;
 }
 
-QByteArray Message::payload() const
+const QByteArray &Message::payload() const
 {
     return _payload;
 }
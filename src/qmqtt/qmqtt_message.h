@@ -58,10 +58,10 @@ public:
     bool dup();
     void setDup(bool dup);
 
-    QString topic() const;
+    const QString &topic() const;
     void setTopic(const QString &topic);
 
-    QByteArray payload() const;
+    const QByteArray &payload() const;
     void setPayload(const QByteArray & payload);
 
 private:
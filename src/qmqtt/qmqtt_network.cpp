@@ -30,7 +30,6 @@
  *
  */
 
-#include <QDataStream>
 #include <QLoggingCategory>
 #include "qmqtt_network.h"
 
@@ -38,16 +37,24 @@ namespace QMQTT {
 
 Q_LOGGING_CATEGORY(network, "qmqtt.network")
 
+/* read from the socket per parse; Qt buffers at most a few of these */
+static const int readChunkBytes = 16384;
+
 Network::Network(QObject *parent) :
     QObject(parent)
 {
-    _buffer = new QBuffer(this);
-    _offsetBuf = 0;
-    _leftSize = 0;
+    _maxPacketSize = 256 * 1024;
+    _inBuffer.reserve(16384);
     _autoreconn = false;
     _timeout = 3000;
     _connected = false;
-    _buffer->open(QIODevice::ReadWrite);
+    _outFrames = 0;
+    _flushBytes = 16384;
+    _flushDelay = 0;
+    _outBuffer.reserve(_flushBytes);
+    _flushTimer = new QTimer(this);
+    _flushTimer->setSingleShot(true);
+    connect(_flushTimer, SIGNAL(timeout()), this, SLOT(flush()));
     initSocket();
 }
 
@@ -59,6 +66,8 @@ void Network::initSocket()
     }
 
     _socket = new QTcpSocket(this);
+    /* a peer sending faster than we parse is held back by TCP */
+    _socket->setReadBufferSize(4 * readChunkBytes);
     connect(_socket, SIGNAL(connected()), this, SLOT(sockConnected()));
     connect(_socket, SIGNAL(disconnected()), this, SLOT(sockDisconnected()));
     connect(_socket, SIGNAL(readyRead()), this, SLOT(sockReadReady()));
@@ -91,17 +100,69 @@ void Network::connectTo(const QString & host, const quint32 port)
 
 void Network::sendFrame(Frame & frame)
 {
+    char fixed[5];
+    fixed[0] = (char)frame.header();
+    int fixedLength = 1 + Frame::encodeLength(fixed + 1, frame.data().size());
+    sendData(fixed, fixedLength);
+    sendData(frame.data().constData(), frame.data().size());
+    endFrame();
+}
 
+void Network::sendData(const char *data, int length)
+{
     if(_socket->state() == QAbstractSocket::ConnectedState)
     {
-        QDataStream out(_socket);
-        frame.write(out);
+        _outBuffer.append(data, length);
+        if(!_flushTimer->isActive()) {
+            _flushTimer->start(_flushDelay);
+        }
     }
+}
 
+void Network::endFrame()
+{
+    if(_outBuffer.isEmpty()) {
+        return;
+    }
+    _outFrames++;
+    _stats.frames++;
+    if(_outBuffer.size() >= _flushBytes) {
+        flush();
+    }
+}
+
+void Network::setCoalescing(int maxBytes, int delayMsecs)
+{
+    _flushBytes = maxBytes;
+    _flushDelay = delayMsecs;
+    _outBuffer.reserve(_flushBytes);
+}
+
+void Network::flush()
+{
+    _flushTimer->stop();
+    if(_outBuffer.isEmpty()) {
+        return;
+    }
+    if(_socket && _socket->state() == QAbstractSocket::ConnectedState)
+    {
+        _socket->write(_outBuffer.constData(), _outBuffer.size());
+        _socket->flush();
+        _stats.flushes++;
+        _stats.bytes += _outBuffer.size();
+        if(_outFrames > _stats.framesPerFlushMax) {
+            _stats.framesPerFlushMax = _outFrames;
+        }
+    }
+    // capacity is reserved, so this keeps the allocation
+    _outBuffer.resize(0);
+    _outFrames = 0;
 }
 
 void Network::disconnect()
 {
+    // DISCONNECT may still be waiting
+    flush();
     if(_socket) _socket->close();
 }
 
@@ -130,59 +191,101 @@ void Network::sockConnected()
 {
     qCDebug(network) << "Network connected...";
     _connected = true;
+    _inBuffer.resize(0);
+    emit socketConnected(_socket->socketDescriptor());
     emit connected();
 }
 
+/*
+ * Appends what arrived to whatever partial frame is left from the last
+ * read, so a frame may be split at any byte, header and length included.
+ * At most readChunkBytes are read before parsing, so the buffer holds no
+ * more than one partial packet and a chunk
+ */
 void Network::sockReadReady()
 {
-    qCDebug(network) << "sockReadReady...";
-    QDataStream in(_socket);
-    QDataStream out(_buffer);
-    while(!_socket->atEnd())
-    {
-        if(_leftSize == 0)
-        {
-            _leftSize  = 0;
-            _offsetBuf = 0;
+    while(_socket && _socket->bytesAvailable() > 0) {
+        int used = _inBuffer.size();
+        int chunk = (int)qMin<qint64>(_socket->bytesAvailable(), readChunkBytes);
+        _inBuffer.resize(used + chunk);
+        qint64 got = _socket->read(_inBuffer.data() + used, chunk);
+        _inBuffer.resize(used + (int)qMax<qint64>(got, 0));
+        if(got <= 0) {
+            return;
+        }
 
-            in >> _header;
-            _leftSize = readRemaingLength(in);
+        int consumed = parseFrames();
+        if(consumed < 0) {
+            return;
         }
-        QByteArray data;
-        data.resize(_leftSize);
-        _offsetBuf = in.readRawData(data.data(), data.size());
-        _leftSize -= _offsetBuf;
-        out.writeRawData(data.data(), _offsetBuf);
-        if(_leftSize == 0)
-        {
-            _buffer->reset();
-            Frame frame(_header, _buffer->buffer());
-            _buffer->buffer().clear();
-            qCDebug(network) << "network emit received(frame), header: " << _header;
-            emit received(frame);
+        // only a partial frame is moved, and the capacity is kept
+        if(consumed > 0) {
+            _inBuffer.remove(0, consumed);
         }
     }
 }
 
 /*
- * Read remaining length
+ * Emits each complete frame in place; returns the bytes consumed, or -1
+ * if the connection went away meanwhile
  */
-int Network::readRemaingLength(QDataStream &in)
+int Network::parseFrames()
 {
-     qint8 byte;
-     int len = 0;
-     int mul = 1;
-     do {
-         in >> byte;
-         len += (byte & 127) * mul;
-         mul *= 128  ;
-     } while ((byte & 128) != 0);
-     return len;
+    int pos = 0;
+    while(_inBuffer.size() - pos >= 2)
+    {
+        const char *data = _inBuffer.constData() + pos;
+        int available = _inBuffer.size() - pos;
+
+        // remaining length: up to four bytes, seven bits each
+        int length = 0;
+        int mul = 1;
+        int lengthBytes = 0;
+        quint8 byte = 0;
+        do {
+            if(1 + lengthBytes >= available) {
+                return pos;
+            }
+            byte = data[1 + lengthBytes++];
+            length += (byte & 127) * mul;
+            mul *= 128;
+            // refused as soon as the length is known to be too large
+            if(length > _maxPacketSize) {
+                break;
+            }
+        } while((byte & 128) != 0 && lengthBytes < 4);
+
+        if((byte & 128) != 0 || length > _maxPacketSize) {
+            qCWarning(network) << "inbound packet too large or malformed; closing";
+            _stats.oversized++;
+            _inBuffer.resize(0);
+            _socket->abort();
+            return -1;
+        }
+
+        int total = 1 + lengthBytes + length;
+        if(available < total) {
+            return pos;
+        }
+
+        FrameView frame((quint8)data[0], data + 1 + lengthBytes, length);
+        _stats.received++;
+        qCDebug(network) << "network emit received(frame), header: " << (quint8)data[0];
+        emit received(frame);
+        if(!_connected) {
+            return -1;
+        }
+        pos += total;
+    }
+    return pos;
 }
 
 void Network::sockDisconnected()
 {
     _connected = false;
+    _inBuffer.resize(0);
+    _outBuffer.resize(0);
+    _outFrames = 0;
     emit disconnected();
 }
 
@@ -34,8 +34,8 @@
 
 #include <QObject>
 #include <QTcpSocket>
+#include <QTimer>
 #include <QPointer>
-#include <QBuffer>
 #include <QByteArray>
 
 #include "qmqtt_frame.h"
@@ -52,6 +52,31 @@ public:
 
     void disconnect();
     void sendFrame(Frame & frame);
+    // part of a packet; the parts of one packet are written back to
+    // back and followed by endFrame()
+    void sendData(const char *data, int length);
+    void endFrame();
+
+    /*
+     * Frames are gathered into one buffer and written to the socket
+     * together: at the end of the event loop iteration (or after
+     * delayMsecs), or at once when maxBytes are waiting
+     */
+    struct Stats {
+        quint64 frames = 0;
+        quint64 flushes = 0;        // one socket write each
+        quint64 bytes = 0;
+        int framesPerFlushMax = 0;
+        quint64 received = 0;       // inbound frames
+        quint64 oversized = 0;      // connections dropped for a packet too large
+    };
+
+    void setCoalescing(int maxBytes, int delayMsecs);
+
+    // larger inbound packets close the connection
+    void setMaxPacketSize(int bytes) { _maxPacketSize = bytes; }
+    int maxPacketSize() const { return _maxPacketSize; }
+    const Stats &stats() const { return _stats; }
 
     bool isConnected();
 
@@ -62,9 +87,13 @@ public:
 
 signals:
     void connected();
+    // the socket is up; emitted before connected() so options can be
+    // set before CONNECT goes out
+    void socketConnected(qintptr descriptor);
     void disconnected();
     void error(QAbstractSocket::SocketError);
-    void received(Frame &frame);
+    // only valid during the call
+    void received(FrameView &frame);
 
 public slots:
     void connectTo(const QString & host, quint32 port);
@@ -76,24 +105,30 @@ private slots:
     //TODO: FIX LATER, add reconnect feature
     //void sockError(QAbstractSocket::SocketError);
     void sockDisconnected();
+    void flush();
 
 private:
     void initSocket();
-    int readRemaingLength(QDataStream &in);
+    int parseFrames();
     //sock
     quint32 _port;
     QString _host;
     QPointer<QTcpSocket> _socket;
-    //read data
-    QPointer<QBuffer> _buffer;
-    quint8 _header;
-    int _offsetBuf;
-    int _leftSize;
+    //read data; a partial frame waits at the start of _inBuffer
+    QByteArray _inBuffer;
+    int _maxPacketSize;
     //autoconn
     bool _autoreconn;
     quint16 _timeout;
     //state
     bool _connected;
+    //write coalescing
+    QByteArray _outBuffer;
+    int _outFrames;
+    int _flushBytes;
+    int _flushDelay;
+    QPointer<QTimer> _flushTimer;
+    Stats _stats;
 };
 
 } // namespace QMQTT
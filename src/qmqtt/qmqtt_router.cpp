@@ -33,6 +33,7 @@
 #include "qmqtt_router.h"
 
 #include "qmqtt_client.h"
+#include "qmqtt_message.h"
 #include "qmqtt_routesubscription.h"
 #include <QLoggingCategory>
 
@@ -40,18 +41,109 @@ namespace QMQTT {
 
 Q_LOGGING_CATEGORY(router, "qmqtt.router")
 
+Router::Node::~Node()
+{
+    qDeleteAll(children);
+    delete plus;
+}
+
 Router::Router(Client *parent) : QObject(parent), _client(parent)
 {
+    connect(_client, &Client::received, this, &Router::routeMessage);
 }
 
-RouteSubscription *Router::subscribe(const QString &route)
+RouteSubscription *Router::subscribe(const QString &route, quint8 qos)
 {
     RouteSubscription *subscription = new RouteSubscription(this);
     subscription->setRoute(route);
-    _client->subscribe(subscription->_topic, 0);
-    connect(_client, &Client::received, subscription, &RouteSubscription::routeMessage);
+    subscription->_qos = qos;
+    insert(subscription);
+    _subscriptions.append(subscription);
+
+    // otherwise sent by resubscribe() once connected
+    if(_client->isConnected())
+        _client->subscribe(subscription->_topic, qos);
     return subscription;
 }
 
-} // namespace QMQTT
+void Router::resubscribe()
+{
+    foreach(RouteSubscription *subscription, _subscriptions)
+        _client->subscribe(subscription->_topic, subscription->_qos);
+}
 
+void Router::insert(RouteSubscription *subscription)
+{
+    Node *node = &_root;
+    foreach(const RouteSubscription::Level &level, subscription->_levels) {
+        switch(level.kind) {
+        case RouteSubscription::Level::Literal: {
+            QStringRef text(&level.text);
+            Node *next = child(node, text);
+            if(!next) {
+                next = new Node;
+                next->level = level.text;
+                node->children.insert(qHash(text), next);
+            }
+            node = next;
+            break;
+        }
+        case RouteSubscription::Level::Plus:
+            if(!node->plus) node->plus = new Node;
+            node = node->plus;
+            break;
+        case RouteSubscription::Level::Hash:
+            node->hashRoutes.append(subscription);
+            return;
+        }
+    }
+    node->routes.append(subscription);
+}
+
+Router::Node *Router::child(const Node *node, const QStringRef &level)
+{
+    uint hash = qHash(level);
+    for(auto it = node->children.constFind(hash);
+        it != node->children.constEnd() && it.key() == hash; ++it) {
+        if(it.value()->level == level) return it.value();
+    }
+    return nullptr;
+}
+
+/*
+ * One step per topic level; a "+" branch is only taken where a route
+ * put one, so the walk stays O(depth) for literal routes
+ */
+void Router::match(const Node *node, const QVector<QStringRef> &levels, int depth,
+                   QList<RouteSubscription *> &matches) const
+{
+    // wildcards do not match a first level starting with "$" [MQTT-4.7.2-1]
+    bool system = depth == 0 && !levels.isEmpty() && levels.at(0).startsWith(QLatin1Char('$'));
+
+    // "a/#" also matches "a" [MQTT-4.7.1-2]
+    if(!system) matches.append(node->hashRoutes);
+
+    if(depth == levels.size()) {
+        matches.append(node->routes);
+        return;
+    }
+
+    const Node *next = child(node, levels.at(depth));
+    if(next) match(next, levels, depth + 1, matches);
+    if(node->plus && !system) match(node->plus, levels, depth + 1, matches);
+}
+
+void Router::routeMessage(const Message &message)
+{
+    const QString &topic = message.topic();
+    QVector<QStringRef> levels = topic.splitRef(QLatin1Char('/'));
+
+    QList<RouteSubscription *> matches;
+    match(&_root, levels, 0, matches);
+    qCDebug(router) << "Routing topic" << topic << "to" << matches.size() << "route(s)";
+
+    foreach(RouteSubscription *subscription, matches)
+        subscription->routeMessage(message, levels);
+}
+
+} // namespace QMQTT
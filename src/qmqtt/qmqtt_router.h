@@ -34,22 +34,58 @@
 #define QMQTT_ROUTER_H
 
 #include <QObject>
+#include <QHash>
+#include <QList>
+#include <QVector>
+#include <QStringList>
+#include "qmqtt_message.h"
 
 namespace QMQTT {
 
 class Client;
 class RouteSubscription;
 
+/*
+ * Routes are topic filters whose single level wildcards may be named,
+ * eg. "alarm/+:panel/zone/+:zone/command"; a bare ":zone" level stands
+ * for "+:zone" and a trailing "#:rest" names what the "#" matched.
+ * Each route is a path in a trie of topic levels, so a message is
+ * matched by walking its own levels once rather than trying every route.
+ */
 class Router : public QObject
 {
     Q_OBJECT
 public:
     explicit Router(Client *parent = 0);
 
-    RouteSubscription *subscribe(const QString &route);
+    RouteSubscription *subscribe(const QString &route, quint8 qos = 0);
+
+    /* subscribe every route again, eg. after connecting with a clean session */
+    void resubscribe();
+
+private slots:
+    void routeMessage(const QMQTT::Message &message);
 
 private:
+    /* children are keyed by the hash of their level, so a topic level is
+       looked up as a QStringRef without being copied out */
+    struct Node {
+        QString level;
+        QMultiHash<uint, Node *> children;
+        Node *plus = nullptr;
+        QList<RouteSubscription *> routes;      /* the filter ends here */
+        QList<RouteSubscription *> hashRoutes;  /* "#" follows here */
+        ~Node();
+    };
+
+    void insert(RouteSubscription *subscription);
+    static Node *child(const Node *node, const QStringRef &level);
+    void match(const Node *node, const QVector<QStringRef> &levels, int depth,
+               QList<RouteSubscription *> &matches) const;
+
     Client *_client;
+    Node _root;
+    QList<RouteSubscription *> _subscriptions;
 };
 
 } // namespace QMQTT
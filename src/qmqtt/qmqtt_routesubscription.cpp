@@ -54,56 +54,63 @@ void RouteSubscription::setRoute(const QString &route)
 {
     qCDebug(routerSubscription) << "Parsing route:" << route;
 
-    QRegularExpression parameterNamesRegExp("\\:([a-zA-Z0-9]+)"); // note how names must not contain dashes or underscores
-
-    // Remove paramter names to get the actual topic "route"
-    QString topic = route;
-    topic.replace(parameterNamesRegExp, "");
-    qCDebug(routerSubscription) << "Topic:" << topic;
-
-    // Remove the MQTT wildcards to get a regular expression, which matches the parameters
-    QString parameterRegExp = route;
-    parameterRegExp
-            .replace("+", "")
-            .replace(parameterNamesRegExp, "([a-zA-Z0-9_-]+)") // note how parameter values may contain dashes or underscores
-            .replace("#", "")
-            .replace("$", "\\$");
-    qCDebug(routerSubscription) << "Parameter regexp:" << parameterRegExp;
-
-    // Extract the parameter names
-    QRegularExpressionMatchIterator it = parameterNamesRegExp.globalMatch(route);
-    QStringList names;
-    while(it.hasNext()) {
-        QRegularExpressionMatch match = it.next();
-        QString parameterName = match.captured(1);
-        names << parameterName;
+    // "+:name" and ":name" are named single level wildcards, "#:name" a
+    // named multi level one; the names are dropped from the topic filter
+    QStringList topicLevels;
+    QVector<Level> levels;
+    foreach(const QString &text, route.split(QLatin1Char('/'))) {
+        Level level;
+        int colon = text.indexOf(QLatin1Char(':'));
+        QString wildcard = colon < 0 ? text : text.left(colon);
+        if(wildcard == QLatin1String("#")) {
+            level.kind = Level::Hash;
+        } else if(wildcard == QLatin1String("+") || (colon == 0 && text.size() > 1)) {
+            level.kind = Level::Plus;
+            wildcard = QStringLiteral("+");
+        } else {
+            level.kind = Level::Literal;
+            level.text = text;
+            wildcard = text;
+        }
+        if(level.kind != Level::Literal && colon >= 0) {
+            level.text = text.mid(colon + 1);
+            _hasParameters = true;
+        }
+        topicLevels << wildcard;
+        levels << level;
+        if(level.kind == Level::Hash) break;
     }
-    qCDebug(routerSubscription) << "Parameter names: " << names;
 
-    _topic = topic;
-    _parameterNames = names;
-    _regularExpression = QRegularExpression(parameterRegExp);
+    _topic = topicLevels.join(QLatin1Char('/'));
+    _levels = levels;
+    qCDebug(routerSubscription) << "Topic:" << _topic;
 }
 
-void RouteSubscription::routeMessage(const Message &message)
+/*
+ * Called by the Router with the levels of a topic it has already matched
+ * against this route; parameters are taken by position
+ */
+void RouteSubscription::routeMessage(const Message &message, const QVector<QStringRef> &levels)
 {
-    QString topic = message.topic();
-    qCDebug(routerSubscription) << "Routing topic" << topic;
-    QRegularExpressionMatch match = _regularExpression.match(topic);
-    if(!match.hasMatch()) {
-        qCDebug(routerSubscription) << "No match";
-        return;
-    }
-
     RoutedMessage routedMessage(message);
-    qCDebug(routerSubscription) << "Matching paramters:";
-
-    for(int i = 0, c = _parameterNames.size(); i < c; ++i) {
-        QString name = _parameterNames.at(i);
-        QString value = match.captured(i + 1);
-        qCDebug(routerSubscription) << name << "=" << value;
 
-        routedMessage._parameters.insert(name, value);
+    if(_hasParameters) {
+        for(int i = 0, c = _levels.size(); i < c; ++i) {
+            const Level &level = _levels.at(i);
+            if(level.kind == Level::Literal || level.text.isEmpty())
+                continue;
+
+            QString value;
+            if(level.kind == Level::Hash) {
+                // the rest of the topic, empty when "a/#" matched "a"
+                if(i < levels.size())
+                    value = message.topic().mid(levels.at(i).position());
+            } else {
+                value = levels.at(i).toString();
+            }
+            qCDebug(routerSubscription) << level.text << "=" << value;
+            routedMessage._parameters.insert(level.text, value);
+        }
     }
 
     emit received(routedMessage);
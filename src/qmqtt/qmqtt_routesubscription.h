@@ -34,7 +34,8 @@
 #define QMQTT_ROUTESUBSCRIPTION_H
 
 #include <QObject>
-#include <QRegularExpression>
+#include <QStringList>
+#include <QVector>
 
 namespace QMQTT {
 
@@ -51,17 +52,22 @@ public:
 signals:
     void received(const RoutedMessage &message);
 
-private slots:
-    void routeMessage(const Message &message);
-
 private:
     friend class Router;
     explicit RouteSubscription(Router *parent = 0);
     void setRoute(const QString &route);
+    void routeMessage(const Message &message, const QVector<QStringRef> &levels);
+
+    struct Level {
+        enum Kind { Literal, Plus, Hash };
+        Kind kind;
+        QString text;   /* the level, or the parameter name if any */
+    };
 
     QString _topic;
-    QRegularExpression _regularExpression;
-    QStringList _parameterNames;
+    quint8 _qos = 0;
+    QVector<Level> _levels;
+    bool _hasParameters = false;
 };
 
 } // namespace QMQTT
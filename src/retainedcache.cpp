@@ -0,0 +1,43 @@
+#include "retainedcache.h"
+
+bool RetainedCache::shouldSend(const QString &topic, const QByteArray &payload)
+{
+    auto it = values.constFind(topic);
+    if (it != values.constEnd() && it.value().acknowledged &&
+            it.value().payload == payload) {
+        _stats.suppressed++;
+        return false;
+    }
+    return true;
+}
+
+void RetainedCache::sent(const QString &topic, QByteArray payload,
+                         quint16 id, int qos)
+{
+    _stats.sent++;
+    values.insert(topic, Value { std::move(payload), id, qos == 0 });
+    if (qos > 0) awaitingAck.insert(id, topic);
+}
+
+void RetainedCache::acknowledged(quint16 id)
+{
+    auto it = awaitingAck.find(id);
+    if (it == awaitingAck.end()) return;
+
+    // a newer value may have replaced the one this id carried; it is
+    // then still awaiting its own PUBACK
+    auto value = values.find(it.value());
+    if (value != values.end() && value.value().id == id &&
+            !value.value().acknowledged) {
+        value.value().acknowledged = true;
+        _stats.acknowledged++;
+    }
+    awaitingAck.erase(it);
+}
+
+void RetainedCache::invalidate()
+{
+    values.clear();
+    awaitingAck.clear();
+    _stats.invalidations++;
+}
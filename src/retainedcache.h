@@ -0,0 +1,55 @@
+#ifndef RETAINEDCACHE_H
+#define RETAINEDCACHE_H
+
+#include <QHash>
+#include <QString>
+#include <QByteArray>
+
+/**
+  * RetainedCache
+  * Last value of each retained topic as the broker acknowledged it
+  * A retained publish that repeats an acknowledged value is dropped;
+  * one still awaiting its PUBACK is not, since it may yet be lost
+  */
+class RetainedCache
+{
+public:
+
+    struct Stats {
+        uint64_t sent = 0;
+        uint64_t suppressed = 0;
+        uint64_t acknowledged = 0;
+        uint64_t invalidations = 0;
+    };
+
+    // false if the broker already holds payload for topic
+    bool shouldSend(const QString &topic, const QByteArray &payload);
+
+    // record a retained publish; QoS 0 is taken as delivered, otherwise
+    // the value counts once id is acknowledged
+    void sent(const QString &topic, QByteArray payload, quint16 id, int qos);
+
+    void acknowledged(quint16 id);
+
+    // forget everything, eg. when the broker connection is lost
+    void invalidate();
+
+    int count() const { return values.count(); }
+    const Stats &stats() const { return _stats; }
+
+private:
+
+    struct Value {
+        QByteArray payload;
+        quint16 id;         // of the publish that carried it
+        bool acknowledged;
+    };
+
+    QHash<QString,Value> values;
+    QHash<quint16,QString> awaitingAck;
+
+    Stats _stats;
+
+};
+
+#endif // RETAINEDCACHE_H
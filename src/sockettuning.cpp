@@ -0,0 +1,80 @@
+#include "sockettuning.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+static bool setOption(qintptr fd, int level, int name, int value,
+                      const char *label, QStringList *failed)
+{
+    if (setsockopt(static_cast<int>(fd), level, name, &value, sizeof(value)) == 0)
+        return true;
+    *failed << QString("%1 (%2)").arg(label).arg(strerror(errno));
+    return false;
+}
+
+QStringList SocketTuning::apply(qintptr fd) const
+{
+    QStringList failed;
+    if (fd < 0) {
+        failed << QString("no socket");
+        return failed;
+    }
+
+    if (noDelay)
+        setOption(fd, IPPROTO_TCP, TCP_NODELAY, 1, "nodelay", &failed);
+
+#ifdef TCP_QUICKACK
+    if (quickAck)
+        setOption(fd, IPPROTO_TCP, TCP_QUICKACK, 1, "quickack", &failed);
+#endif
+
+    if (keepIdleSecs > 0) {
+        setOption(fd, SOL_SOCKET, SO_KEEPALIVE, 1, "keepalive", &failed);
+#ifdef TCP_KEEPIDLE
+        setOption(fd, IPPROTO_TCP, TCP_KEEPIDLE, keepIdleSecs, "keepidle", &failed);
+        setOption(fd, IPPROTO_TCP, TCP_KEEPINTVL, keepIntervalSecs, "keepintvl", &failed);
+        setOption(fd, IPPROTO_TCP, TCP_KEEPCNT, keepCount, "keepcnt", &failed);
+#endif
+    }
+
+#ifdef TCP_USER_TIMEOUT
+    if (userTimeoutMsecs > 0)
+        setOption(fd, IPPROTO_TCP, TCP_USER_TIMEOUT, userTimeoutMsecs,
+                  "user_timeout", &failed);
+#endif
+
+#ifdef SO_PRIORITY
+    if (priority >= 0)
+        setOption(fd, SOL_SOCKET, SO_PRIORITY, priority, "priority", &failed);
+#endif
+
+    return failed;
+}
+
+void SocketTuning::rearmQuickAck(qintptr fd)
+{
+#ifdef TCP_QUICKACK
+    int value = 1;
+    setsockopt(static_cast<int>(fd), IPPROTO_TCP, TCP_QUICKACK, &value, sizeof(value));
+#else
+    Q_UNUSED(fd);
+#endif
+}
+
+QString SocketTuning::describe() const
+{
+    QStringList options;
+    if (noDelay) options << "nodelay";
+    if (quickAck) options << "quickack";
+    if (keepIdleSecs > 0)
+        options << QString("keepalive %1/%2/%3")
+                   .arg(keepIdleSecs).arg(keepIntervalSecs).arg(keepCount);
+    if (userTimeoutMsecs > 0)
+        options << QString("user_timeout %1ms").arg(userTimeoutMsecs);
+    if (priority >= 0)
+        options << QString("priority %1").arg(priority);
+    return options.join(" ");
+}
@@ -0,0 +1,41 @@
+#ifndef SOCKETTUNING_H
+#define SOCKETTUNING_H
+
+#include <QString>
+#include <QStringList>
+
+/**
+  * SocketTuning
+  * Latency mode for a connected TCP socket: no Nagle, no delayed ACK,
+  * and keepalive plus a user timeout so a half-open link is noticed
+  * in seconds rather than at the application timeout
+  */
+struct SocketTuning
+{
+    bool noDelay = true;
+    bool quickAck = true;
+
+    // idle time before the first probe, then probes every interval;
+    // the link is dropped after count unanswered probes
+    int keepIdleSecs = 10;
+    int keepIntervalSecs = 5;
+    int keepCount = 3;
+
+    // unacknowledged data is given up on after this long; matches
+    // the keepalive budget above
+    int userTimeoutMsecs = 25000;
+
+    // SO_PRIORITY queueing band, 0-6 without CAP_NET_ADMIN
+    int priority = 6;
+
+    // set the options on fd; returns what could not be set
+    QStringList apply(qintptr fd) const;
+
+    // TCP_QUICKACK is not sticky; set it again after each read
+    static void rearmQuickAck(qintptr fd);
+
+    // eg. "nodelay quickack keepalive 10/5/3 user_timeout 25000ms priority 6"
+    QString describe() const;
+};
+
+#endif // SOCKETTUNING_H
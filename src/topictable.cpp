@@ -0,0 +1,72 @@
+#include "topictable.h"
+
+#include <qmqtt/qmqtt_frame.h>
+
+static const char *zoneTopicNames[] = {
+    "event", "state", "condition"
+};
+
+static const char *partitionTopicNames[] = {
+    "event", "armed", "state", "hass_state", "condition",
+    "user_armed", "user_disarmed", "user_event"
+};
+
+PublishTopic::PublishTopic(const QString &name) :
+    name(name),
+    encoded(QMQTT::Frame::encodeString(name))
+{
+}
+
+void TopicTable::build(const QString &prefix)
+{
+    this->prefix = prefix;
+    extraTopics.clear();
+
+    zoneTopics.clear();
+    zoneTopics.reserve(zoneCount * ZoneTopicCount);
+    for (int zone = 1; zone <= zoneCount; zone++)
+        for (int topic = 0; topic < ZoneTopicCount; topic++)
+            zoneTopics.append(PublishTopic(QString("%1/zone/%2/%3")
+                                           .arg(prefix).arg(zone)
+                                           .arg(zoneTopicNames[topic])));
+
+    partitionTopics.clear();
+    partitionTopics.reserve(partitionCount * PartitionTopicCount);
+    for (int partition = 1; partition <= partitionCount; partition++)
+        for (int topic = 0; topic < PartitionTopicCount; topic++)
+            partitionTopics.append(PublishTopic(QString("%1/partition/%2/%3")
+                                                .arg(prefix).arg(partition)
+                                                .arg(partitionTopicNames[topic])));
+
+    systemTopics.clear();
+    systemTopics.append(PublishTopic(QString("%1/event").arg(prefix)));
+    systemTopics.append(PublishTopic(QString("%1/availability").arg(prefix)));
+    systemTopics.append(PublishTopic(QString("%1/synced").arg(prefix)));
+    systemTopics.append(PublishTopic(QString("%1/keypad_lcd_data").arg(prefix)));
+    systemTopics.append(PublishTopic(QString("%1/keypad/result").arg(prefix)));
+    systemTopics.append(PublishTopic(QString("alarm/event")));
+}
+
+const PublishTopic &TopicTable::zone(int zone, ZoneTopic topic) const
+{
+    if (zone >= 1 && zone <= zoneCount)
+        return zoneTopics.at((zone - 1) * ZoneTopicCount + topic);
+    return overflow(QString("%1/zone/%2/%3").arg(prefix).arg(zone)
+                    .arg(zoneTopicNames[topic]));
+}
+
+const PublishTopic &TopicTable::partition(int partition, PartitionTopic topic) const
+{
+    if (partition >= 1 && partition <= partitionCount)
+        return partitionTopics.at((partition - 1) * PartitionTopicCount + topic);
+    return overflow(QString("%1/partition/%2/%3").arg(prefix).arg(partition)
+                    .arg(partitionTopicNames[topic]));
+}
+
+const PublishTopic &TopicTable::overflow(const QString &name) const
+{
+    auto it = extraTopics.find(name);
+    if (it == extraTopics.end())
+        it = extraTopics.insert(name, PublishTopic(name));
+    return it.value();
+}
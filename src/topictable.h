@@ -0,0 +1,84 @@
+#ifndef TOPICTABLE_H
+#define TOPICTABLE_H
+
+#include <QHash>
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+
+/**
+  * PublishTopic
+  * A topic name alongside its MQTT wire encoding, so publishing to it
+  * only has to append the payload
+  */
+struct PublishTopic {
+    QString name;
+    QByteArray encoded;
+
+    PublishTopic() {}
+    explicit PublishTopic(const QString &name);
+};
+
+/**
+  * TopicTable
+  * Every fixed topic under a panel's prefix, encoded once up front.
+  * Zones and partitions outside the built range are encoded on first
+  * use and kept
+  */
+class TopicTable
+{
+public:
+
+    inline static const int zoneCount = 64;
+    inline static const int partitionCount = 8;
+
+    enum ZoneTopic {
+        ZoneEvent,
+        ZoneState,
+        ZoneCondition,
+        ZoneTopicCount
+    };
+
+    enum PartitionTopic {
+        PartitionEvent,
+        PartitionArmed,
+        PartitionState,
+        PartitionHassState,
+        PartitionCondition,
+        PartitionUserArmed,
+        PartitionUserDisarmed,
+        PartitionUserEvent,
+        PartitionTopicCount
+    };
+
+    enum SystemTopic {
+        SystemEvent,
+        SystemAvailability,
+        SystemSynced,
+        SystemKeypadLcdData,
+        SystemKeypadResult,
+        SystemAlarmEvent,       // shared by all panels, not under the prefix
+        SystemTopicCount
+    };
+
+    void build(const QString &prefix);
+
+    const PublishTopic &zone(int zone, ZoneTopic topic) const;
+    const PublishTopic &partition(int partition, PartitionTopic topic) const;
+    const PublishTopic &system(SystemTopic topic) const { return systemTopics.at(topic); }
+
+private:
+
+    const PublishTopic &overflow(const QString &name) const;
+
+    QString prefix;
+
+    QVector<PublishTopic> zoneTopics;       // [zone - 1][topic]
+    QVector<PublishTopic> partitionTopics;  // [partition - 1][topic]
+    QVector<PublishTopic> systemTopics;
+
+    mutable QHash<QString,PublishTopic> extraTopics;
+
+};
+
+#endif // TOPICTABLE_H
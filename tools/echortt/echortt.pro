@@ -0,0 +1,18 @@
+QT       += core
+QT       -= gui
+
+TARGET = echortt
+
+CONFIG += c++17 console thread
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+SRC = $$PWD/../../src
+INCLUDEPATH += $$SRC
+
+SOURCES += main.cpp \
+    $$SRC/sockettuning.cpp
+
+HEADERS += \
+    $$SRC/sockettuning.h
@@ -0,0 +1,137 @@
+#include <QDebug>
+#include <QString>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "sockettuning.h"
+
+/**
+  * echortt [rounds] [size]
+  * Request/response round trips over loopback TCP, with and without
+  * the latency mode the bridge applies to its sockets
+  * Each request is written as a 2 byte header and then the rest, as
+  * QMQTT::Network writes a publish; the peer answers once the whole
+  * request is in, as a broker answers with PUBACK. Without nodelay the
+  * second write waits on the ACK for the first, which the peer delays
+  */
+
+static bool readFully(int fd, char *data, int size)
+{
+    int done = 0;
+    while (done < size) {
+        ssize_t n = ::read(fd, data + done, size - done);
+        if (n <= 0) return false;
+        done += static_cast<int>(n);
+    }
+    return true;
+}
+
+static bool writeFully(int fd, const char *data, int size)
+{
+    int done = 0;
+    while (done < size) {
+        ssize_t n = ::write(fd, data + done, size - done);
+        if (n <= 0) return false;
+        done += static_cast<int>(n);
+    }
+    return true;
+}
+
+// answers each request of size bytes with 4 bytes, untuned
+static void echoPeer(int listener, int size)
+{
+    int fd = ::accept(listener, nullptr, nullptr);
+    if (fd < 0) return;
+
+    std::vector<char> request(size);
+    const char reply[4] = { 0x40, 0x02, 0x00, 0x01 };
+    while (readFully(fd, request.data(), size) && writeFully(fd, reply, sizeof(reply))) {}
+    ::close(fd);
+}
+
+static QString run(int rounds, int size, const SocketTuning *tuning)
+{
+    int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (::bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 ||
+            ::listen(listener, 1) < 0 ||
+            ::getsockname(listener, reinterpret_cast<sockaddr *>(&address), &length) < 0)
+        return QString("unable to listen: %1").arg(strerror(errno));
+
+    std::thread peer(echoPeer, listener, size);
+
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+        ::close(listener);
+        peer.join();
+        return QString("unable to connect: %1").arg(strerror(errno));
+    }
+
+    QString failed;
+    if (tuning) failed = tuning->apply(fd).join(", ");
+
+    std::vector<char> request(size, 'x');
+    char reply[4];
+    std::vector<int64_t> rtts;
+    rtts.reserve(rounds);
+
+    for (int i = 0; i < rounds; i++) {
+        auto start = std::chrono::steady_clock::now();
+        if (!writeFully(fd, request.data(), 2) ||
+                !writeFully(fd, request.data() + 2, size - 2) ||
+                !readFully(fd, reply, sizeof(reply)))
+            break;
+        if (tuning && tuning->quickAck) SocketTuning::rearmQuickAck(fd);
+        rtts.push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+
+    ::close(fd);
+    peer.join();
+    ::close(listener);
+
+    if (rtts.empty()) return QString("no round trips");
+
+    std::sort(rtts.begin(), rtts.end());
+    int64_t sum = 0;
+    for (int64_t rtt : rtts) sum += rtt;
+
+    QString result = QString("%1 rounds: min %2 us, avg %3 us, p50 %4 us, p99 %5 us, max %6 us")
+            .arg(rtts.size())
+            .arg(rtts.front())
+            .arg(sum / static_cast<int64_t>(rtts.size()))
+            .arg(rtts[rtts.size() / 2])
+            .arg(rtts[rtts.size() * 99 / 100])
+            .arg(rtts.back());
+    if (!failed.isEmpty()) result += QString(" (not set: %1)").arg(failed);
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    int rounds = argc > 1 ? atoi(argv[1]) : 200;
+    int size = argc > 2 ? qMax(3, atoi(argv[2])) : 40;
+
+    SocketTuning tuning;
+
+    qDebug() << qPrintable(QString("default:      %1").arg(run(rounds, size, nullptr)));
+    qDebug() << qPrintable(QString("latency mode: %1").arg(run(rounds, size, &tuning)));
+    qDebug() << qPrintable(QString("(%1)").arg(tuning.describe()));
+
+    return 0;
+}
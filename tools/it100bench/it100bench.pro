@@ -0,0 +1,27 @@
+QT       += core network
+QT       -= gui
+
+TARGET = it100bench
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+SRC = $$PWD/../../src
+INCLUDEPATH += $$SRC
+
+SOURCES += main.cpp \
+    $$SRC/it100.cpp \
+    $$SRC/it100message.cpp \
+    $$SRC/it100commandqueue.cpp \
+    $$SRC/it100pacer.cpp \
+    $$SRC/it100framer.cpp \
+    $$SRC/it100transport.cpp \
+    $$SRC/connectionsupervisor.cpp \
+    $$SRC/sockettuning.cpp
+
+HEADERS += \
+    $$SRC/it100.h \
+    $$SRC/it100transport.h \
+    $$SRC/connectionsupervisor.h
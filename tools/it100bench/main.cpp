@@ -0,0 +1,150 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QDebug>
+
+#include <ctime>
+
+#include "it100.h"
+#include "it100commands.h"
+
+/**
+  * it100bench [lines] [commands]
+  * Drives IT100 through a LoopbackTransport at full speed: synthetic
+  * zone and partition lines in, then commands out through the window
+  * with each one acknowledged by the loopback. Reports the cpu time
+  * per line and per command as seen by the thread running IT100
+  */
+
+using namespace it100;
+
+class CountingConsumer : public PanelEventConsumer
+{
+public:
+    void onPanelEvent(const PanelEvent &event) override { events++; (void)event; }
+    uint64_t events = 0;
+};
+
+static int64_t threadCpuNsecs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// code + data + checksum + CR/LF, as the module sends it
+static void appendLine(QByteArray &out, const QByteArray &frame)
+{
+    char sum[2];
+    writeChecksum(checksum(frame.constData(), frame.size()), sum);
+    out.append(frame).append(sum, 2).append("\r\n");
+}
+
+// zones opening and restoring across 64 zones, the odd partition change
+static QByteArray syntheticBatch(int lines)
+{
+    QByteArray batch;
+    for (int i = 0; i < lines; i++) {
+        if (i % 16 == 15) {
+            appendLine(batch, QByteArray(i % 32 == 31 ? "650" : "651").append('1'));
+        } else {
+            QByteArray zone = QByteArray::number(1 + i % 64).rightJustified(3, '0');
+            appendLine(batch, QByteArray(i % 2 ? "610" : "609").append(zone));
+        }
+    }
+    return batch;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    int totalLines = argc > 1 ? atoi(argv[1]) : 200000;
+    int totalCommands = argc > 2 ? atoi(argv[2]) : 20000;
+    const int batchLines = 64;
+
+    IT100 module(false);
+    CountingConsumer consumer;
+    module.setEventConsumer(&consumer);
+
+    LoopbackTransport *transport = new LoopbackTransport();
+    transport->setKeepWritten(false);
+    transport->setAutoAcknowledge(true);
+    module.setTransport(transport);
+
+    // the pacer would hold commands to the serial rate; its burst
+    // still spaces each window by a millisecond
+    module.setLinkBaudRate(100000000);
+    module.setCommandWindow(maxCommandWindow);
+
+    module.open();
+    while (!module.isConnected()) QCoreApplication::processEvents();
+
+    // the status request sent on connecting, and its acknowledgement
+    for (int i = 0; i < 4; i++) QCoreApplication::processEvents();
+
+    // ##########
+    // Lines in
+    // ##########
+
+    QByteArray batch = syntheticBatch(batchLines);
+    uint64_t eventsBefore = consumer.events;
+    uint64_t framedBefore = module.framerStats().linesFramed;
+    QElapsedTimer wall;
+    wall.start();
+    int64_t cpuStart = threadCpuNsecs();
+
+    int lines = 0;
+    while (lines < totalLines) {
+        transport->feed(batch);
+        QCoreApplication::processEvents();
+        lines += batchLines;
+    }
+    while (module.framerStats().linesFramed - framedBefore < uint64_t(lines))
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+
+    int64_t cpu = threadCpuNsecs() - cpuStart;
+    int64_t elapsed = wall.nsecsElapsed();
+    qDebug() << qPrintable(QString("lines: %1 in %2 ms, %3 ns cpu/line, %4 events, %5 lines/s")
+                           .arg(lines)
+                           .arg(elapsed / 1000000)
+                           .arg(cpu / lines)
+                           .arg(consumer.events - eventsBefore)
+                           .arg(static_cast<qint64>(lines * 1e9 / elapsed)));
+
+    const LineFramer::Stats &framer = module.framerStats();
+    qDebug() << qPrintable(QString("framer: %1 lines, %2 checksum rejects, %3 length rejects")
+                           .arg(framer.linesFramed).arg(module.checksumRejectCount())
+                           .arg(module.lengthRejectCount()));
+
+    // ############
+    // Commands out
+    // ############
+
+    uint64_t ackedBefore = module.commandLinkStats().acknowledged;
+    wall.restart();
+    cpuStart = threadCpuNsecs();
+
+    int commands = 0;
+    while (commands < totalCommands) {
+        // command output 1 on partition 1; the interactive lane does
+        // not coalesce repeats as housekeeping would
+        for (int i = 0; i < maxCommandWindow; i++, commands++)
+            module.sendCommand(CMD_COMMAND_OUTPUT_CONTROL, QByteArray("11"));
+        // blocking, so time the pacer spends refilling is not counted
+        while (module.commandLinkStats().acknowledged - ackedBefore < uint64_t(commands))
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    }
+
+    cpu = threadCpuNsecs() - cpuStart;
+    elapsed = wall.nsecsElapsed();
+    const IT100::CommandLinkStats &link = module.commandLinkStats();
+    qDebug() << qPrintable(QString("commands: %1 in %2 ms, %3 ns cpu/command, "
+                                   "%4 retransmits, %5 abandoned")
+                           .arg(commands)
+                           .arg(elapsed / 1000000)
+                           .arg(cpu / commands)
+                           .arg(link.retransmits)
+                           .arg(link.abandoned));
+
+    return 0;
+}
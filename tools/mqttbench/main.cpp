@@ -0,0 +1,205 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QDebug>
+
+#include <ctime>
+#include <vector>
+
+#include <qmqtt/qmqtt.h>
+#include <qmqtt/qmqtt_frame.h>
+
+#include "allocationcounter.h"
+
+/**
+  * mqttbench [publishes] [frames] [--max-allocations N]
+  * Decode: recorded PUBLISH frames read through the old Frame (a QObject
+  * consuming its copy with remove()) and through FrameView; cpu time and
+  * allocations per frame for each
+  * Publish: QoS 0 publishes through QMQTT::Client::publishEncoded() to a
+  * local peer that answers CONNECT and discards the rest; allocations
+  * and cpu time per publish, and frames per socket write
+  * With --max-allocations, exits 1 if a publish averages more than N
+  */
+
+static int64_t threadCpuNsecs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+struct RecordedFrame {
+    quint8 header;
+    QByteArray data;    // after the fixed header
+};
+
+// state and event publishes as the bridge makes them, QoS 0 and 1
+static std::vector<RecordedFrame> recordFrames(int count)
+{
+    static const char *payloads[] = { "open", "closed", "secure", "violated",
+                                      "disarmed", "armed_away", "1", "0" };
+    std::vector<RecordedFrame> frames;
+    frames.reserve(count);
+    for (int i = 0; i < count; i++) {
+        int qos = i % 2;
+        QString topic = (i % 4 < 2)
+                ? QString("idac/module/it100/zone/%1/state").arg(1 + i % 64)
+                : QString("idac/module/it100/partition/%1/event").arg(1 + i % 8);
+        RecordedFrame frame;
+        frame.header = SETQOS(PUBLISH, qos);
+        frame.data = QMQTT::Frame::encodeString(topic);
+        if (qos) frame.data.append(MSB(i + 1)).append(LSB(i + 1));
+        frame.data.append(payloads[i % 8]);
+        frames.push_back(frame);
+    }
+    return frames;
+}
+
+static void reportDecode(const char *name, int frames, int64_t cpu,
+                         uint64_t allocations, int64_t check)
+{
+    qDebug() << qPrintable(QString("decode %1: %2 ns cpu/frame, %3 allocations/frame (%4)")
+                           .arg(name)
+                           .arg(cpu / frames)
+                           .arg(double(allocations) / frames, 0, 'f', 2)
+                           .arg(check));
+}
+
+static void benchDecode(int count)
+{
+    std::vector<RecordedFrame> frames = recordFrames(count);
+
+    // check sums keep the reads from being optimised away
+    int64_t check = 0;
+    uint64_t allocations = AllocationCounter::count();
+    int64_t cpu = threadCpuNsecs();
+    for (const RecordedFrame &recorded : frames) {
+        QByteArray data = recorded.data;
+        QMQTT::Frame frame(recorded.header, data);
+        QString topic = frame.readString();
+        quint16 id = GETQOS(recorded.header) ? frame.readInt() : 0;
+        QByteArray payload = frame.data();
+        check += topic.size() + id + payload.size();
+    }
+    reportDecode("Frame", count, threadCpuNsecs() - cpu,
+                 AllocationCounter::count() - allocations, check);
+
+    check = 0;
+    allocations = AllocationCounter::count();
+    cpu = threadCpuNsecs();
+    for (const RecordedFrame &recorded : frames) {
+        QMQTT::FrameView frame(recorded.header, recorded.data);
+        QString topic = frame.readString();
+        quint16 id = GETQOS(recorded.header) ? frame.readInt() : 0;
+        QByteArray payload = frame.readRest();
+        check += topic.size() + id + payload.size();
+    }
+    reportDecode("FrameView", count, threadCpuNsecs() - cpu,
+                 AllocationCounter::count() - allocations, check);
+}
+
+/**
+  * Peer
+  * Just enough broker: CONNACK for the CONNECT, everything after it
+  * read and dropped
+  */
+class Peer
+{
+public:
+    Peer()
+    {
+        server.listen(QHostAddress::LocalHost);
+        QObject::connect(&server, &QTcpServer::newConnection, [this]() {
+            QTcpSocket *socket = server.nextPendingConnection();
+            QObject::connect(socket, &QTcpSocket::readyRead, [this, socket]() {
+                received += socket->readAll().size();
+                if (!acknowledged) {
+                    acknowledged = true;
+                    socket->write(QByteArray("\x20\x02\x00\x00", 4));
+                }
+            });
+        });
+    }
+
+    quint16 port() const { return server.serverPort(); }
+
+    QTcpServer server;
+    bool acknowledged = false;
+    qint64 received = 0;
+};
+
+static bool benchPublish(int count, double maxAllocations)
+{
+    Peer peer;
+    QMQTT::Client client("127.0.0.1", peer.port());
+    client.setClientId("mqttbench");
+
+    bool connected = false;
+    QObject::connect(&client, &QMQTT::Client::connected, [&connected]() { connected = true; });
+    client.connect();
+    QElapsedTimer wait;
+    wait.start();
+    while (!connected && wait.elapsed() < 5000)
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 100);
+    if (!connected) {
+        qDebug() << "publish: no connection to the local peer";
+        return false;
+    }
+
+    QByteArray topic = QMQTT::Frame::encodeString("idac/module/it100/zone/12/state");
+    QByteArray payload("violated");
+
+    // only the publish calls are counted, as It100Mqtt::writeMqtt() does;
+    // the event loop in between flushes the coalesced writes
+    uint64_t allocations = 0;
+    int64_t cpu = 0;
+    for (int i = 0; i < count; i++) {
+        uint64_t allocationsBefore = AllocationCounter::count();
+        int64_t cpuBefore = threadCpuNsecs();
+        client.publishEncoded(topic, payload, 0, false);
+        cpu += threadCpuNsecs() - cpuBefore;
+        allocations += AllocationCounter::count() - allocationsBefore;
+        if (i % 64 == 63) QCoreApplication::processEvents();
+    }
+    QCoreApplication::processEvents();
+
+    QMQTT::Network::Stats writes = client.writeStats();
+    double perPublish = double(allocations) / count;
+    qDebug() << qPrintable(QString("publish: %1 ns cpu/publish, %2 allocations/publish, "
+                                   "%3 frames in %4 writes")
+                           .arg(cpu / count)
+                           .arg(perPublish, 0, 'f', 2)
+                           .arg(writes.frames)
+                           .arg(writes.flushes));
+    client.disconnect();
+
+    if (maxAllocations >= 0 && perPublish > maxAllocations) {
+        qDebug() << qPrintable(QString("FAIL: more than %1 allocations per publish")
+                               .arg(maxAllocations));
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QStringList args = app.arguments().mid(1);
+    double maxAllocations = -1;
+    int option = args.indexOf("--max-allocations");
+    if (option >= 0 && option + 1 < args.size()) {
+        maxAllocations = args.at(option + 1).toDouble();
+        args.erase(args.begin() + option, args.begin() + option + 2);
+    }
+    int publishes = args.size() > 0 ? args.at(0).toInt() : 100000;
+    int frames = args.size() > 1 ? args.at(1).toInt() : 100000;
+
+    if (!AllocationCounter::enabled())
+        qDebug() << "allocations are not counted on this platform";
+
+    benchDecode(frames);
+    return benchPublish(publishes, maxAllocations) ? 0 : 1;
+}
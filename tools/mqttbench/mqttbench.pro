@@ -0,0 +1,22 @@
+QT       += core network
+QT       -= gui
+
+TARGET = mqttbench
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+SRC = $$PWD/../../src
+INCLUDEPATH += $$SRC
+
+# always counted here; the figure is what this tool is for
+DEFINES += QMQTT_LIBRARY COUNT_ALLOCATIONS
+include($$SRC/qmqtt/qmqtt.pri)
+
+SOURCES += main.cpp \
+    $$SRC/allocationcounter.cpp
+
+HEADERS += \
+    $$SRC/allocationcounter.h
@@ -0,0 +1,8 @@
+# Benchmarks and diagnostics; not installed
+# qmake tools.pro && make, then run each from its own directory
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    it100bench \
+    echortt \
+    mqttbench